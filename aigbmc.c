@@ -202,6 +202,7 @@ static void init () {
   }
 #endif
   model = aiger_init ();
+  aiger_lazy_symbols (model);	/* names are never used */
 }
 
 static void reset () {
@@ -26,9 +26,42 @@ IN THE SOFTWARE.
 
 #include <string.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include <assert.h>
 #include <ctype.h>
+#include <limits.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef AIGER_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef AIGER_HAVE_LZMA
+#include <lzma.h>
+#endif
+
+#ifdef AIGER_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#ifdef AIGER_HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(AIGER_HAVE_ZLIB) || \
+    defined(AIGER_HAVE_LZMA) || \
+    defined(AIGER_HAVE_ZSTD)
+#define AIGER_HAVE_CODEC
+#endif
 
 /*------------------------------------------------------------------------*/
 
@@ -54,6 +87,8 @@ aiger_version (void)
 #define GUNZIP "gzip -d -c %s 2>/dev/null"
 #define XZIP "xz -c > %s 2>/dev/null"
 #define XUNZIP "xz -d -c %s 2>/dev/null"
+#define ZSTDZIP "zstd -q -c > %s 2>/dev/null"
+#define ZSTDUNZIP "zstd -q -d -c %s 2>/dev/null"
 
 #define NEWN(p,n) \
   do { \
@@ -67,11 +102,18 @@ aiger_version (void)
     size_t mbytes = (m) * sizeof (*(p)); \
     size_t nbytes = (n) * sizeof (*(p)); \
     size_t minbytes = (mbytes < nbytes) ? mbytes : nbytes; \
-    void * res = private->malloc_callback (private->memory_mgr, nbytes); \
-    memcpy (res, (p), minbytes); \
+    void * res; \
+    if (private->realloc_callback) \
+      res = private->realloc_callback (private->memory_mgr, \
+                                       (p), mbytes, nbytes); \
+    else \
+      { \
+	res = private->malloc_callback (private->memory_mgr, nbytes); \
+	memcpy (res, (p), minbytes); \
+	private->free_callback (private->memory_mgr, (p), mbytes); \
+      } \
     if (nbytes > mbytes) \
       memset (((char*)res) + mbytes, 0, nbytes - mbytes); \
-    private->free_callback (private->memory_mgr, (p), mbytes); \
     (p) = res; \
   } while (0)
 
@@ -125,7 +167,12 @@ aiger_version (void)
 typedef struct aiger_private aiger_private;
 typedef struct aiger_buffer aiger_buffer;
 typedef struct aiger_reader aiger_reader;
+typedef struct aiger_writer aiger_writer;
 typedef struct aiger_type aiger_type;
+typedef struct aiger_section aiger_section;
+typedef struct aiger_arena aiger_arena;
+typedef struct aiger_arena_block aiger_arena_block;
+typedef struct aiger_symbol_entry aiger_symbol_entry;
 
 struct aiger_type
 {
@@ -141,15 +188,90 @@ struct aiger_type
   unsigned idx;
 };
 
+/* The symbol table and comments section is copied as a whole.  Names and
+ * comments are then parsed in place, either directly after reading or on
+ * demand (see 'aiger_lazy_symbols').
+ */
+struct aiger_section
+{
+  char *start;
+  size_t bytes;
+  size_t size;
+
+  int pending;			/* not parsed yet */
+
+  /* Reader state at the start of the section for error messages.
+   */
+  unsigned lineno;
+  unsigned charno;
+  unsigned lineno_at_last_token_start;
+  int looks_like_aag;
+};
+
+/* Bump allocator for names, comments and justice literals.  Its blocks are
+ * allocated through the memory manager and only released as a whole.
+ */
+struct aiger_arena_block
+{
+  aiger_arena_block *next;
+  size_t size;			/* including this header */
+};
+
+struct aiger_arena
+{
+  aiger_arena_block *blocks;
+  char *cursor;
+  char *end;
+};
+
+#define AIGER_ARENA_BLOCK_SIZE (1u<<16)
+
+/* Entry of the open addressing hash table of names (see
+ * 'aiger_find_symbol').  Empty entries have a zero 'symbol'.
+ */
+struct aiger_symbol_entry
+{
+  aiger_symbol *symbol;
+  unsigned hash;
+  int tag;
+};
+
 struct aiger_private
 {
   aiger public;
 
   aiger_type *types;		/* [0..maxvar] */
-  unsigned size_types;
+  aiger_lit size_types;
+
+  aiger_and and;			/* returned by 'aiger_is_and' if compact */
+
+  aiger_header *header;		/* only during 'aiger_read_header_only' */
+  int skip_ands;		/* see 'aiger_skip_ands' */
+  int lazy_symbols;		/* see 'aiger_lazy_symbols' */
+  unsigned write_threads;	/* see 'aiger_write_threads' */
+
+  const aiger_visitor *visitor;	/* see 'aiger_set_visitor' */
+  aiger_header visited;		/* header of the visited model */
+
+  aiger_section section;
+
+  aiger_arena name_arena;
+  aiger_arena comment_arena;
+  aiger_arena lits_arena;
+
+  int checked;			/* 'aiger_check' succeeded since last change */
 
   unsigned char * coi;
-  unsigned size_coi;
+  aiger_lit size_coi;
+  int coi_cached;		/* 'coi' holds the cone of all properties */
+
+  aiger_fanouts fanouts;
+  aiger_lit size_targets;
+  int fanouts_cached;
+
+  aiger_symbol_entry *symbol_table;	/* see 'aiger_find_symbol' */
+  unsigned size_symbol_table;
+  int symbol_table_cached;
 
   unsigned size_inputs;
   unsigned size_latches;
@@ -165,6 +287,7 @@ struct aiger_private
 
   void *memory_mgr;
   aiger_malloc malloc_callback;
+  aiger_realloc realloc_callback;	/* optional */
   aiger_free free_callback;
 
   char *error;
@@ -177,10 +300,26 @@ struct aiger_buffer
   char *end;
 };
 
+/* Size of the internal buffers used by the block-oriented reader and
+ * writer, e.g., 'aiger_read_blocks' and 'aiger_write_blocks'.
+ */
+#define AIGER_BLOCK_SIZE (1u<<16)
+
 struct aiger_reader
 {
   void *state;
   aiger_get get;
+  aiger_get_block get_block;
+
+  /* Characters are taken directly from this window before falling back to
+   * 'get' or refilling it through 'get_block'.  For memory mapped files it
+   * covers the whole file.
+   */
+  const unsigned char *cursor;
+  const unsigned char *end;
+  char *block;			/* [0..AIGER_BLOCK_SIZE[ for 'get_block' */
+
+  unsigned threads;		/* for decoding the binary AND section */
 
   int ch;
 
@@ -191,9 +330,10 @@ struct aiger_reader
 
   int done_with_reading_header;
   int looks_like_aag;
+  int compact;			/* compact after reading ASCII */
 
   aiger_mode mode;
-  unsigned maxvar;
+  aiger_lit maxvar;
   unsigned inputs;
   unsigned latches;
   unsigned outputs;
@@ -202,15 +342,25 @@ struct aiger_reader
   unsigned constraints;
   unsigned justice;
   unsigned fairness;
+};
 
-  char *buffer;
-  unsigned top_buffer;
-  unsigned size_buffer;
+struct aiger_writer
+{
+  void *state;
+  aiger_put put;		/* either this one */
+  aiger_put_block put_block;	/* or buffered through 'block' */
+
+  char *cursor;
+  char *block;			/* [0..AIGER_BLOCK_SIZE[ for 'put_block' */
+
+  unsigned threads;		/* see 'aiger_write_threads' */
 };
 
 aiger *
-aiger_init_mem (void *memory_mgr,
-		aiger_malloc external_malloc, aiger_free external_free)
+aiger_init_mem_realloc (void *memory_mgr,
+			aiger_malloc external_malloc,
+			aiger_realloc external_realloc,
+			aiger_free external_free)
 {
   aiger_private *private;
   aiger *public;
@@ -221,6 +371,7 @@ aiger_init_mem (void *memory_mgr,
   CLR (*private);
   private->memory_mgr = memory_mgr;
   private->malloc_callback = external_malloc;
+  private->realloc_callback = external_realloc;
   private->free_callback = external_free;
   public = &private->public;
   PUSH (public->comments, private->num_comments, private->size_comments, 0);
@@ -228,12 +379,27 @@ aiger_init_mem (void *memory_mgr,
   return public;
 }
 
+aiger *
+aiger_init_mem (void *memory_mgr,
+		aiger_malloc external_malloc, aiger_free external_free)
+{
+  return aiger_init_mem_realloc (memory_mgr,
+				 external_malloc, 0, external_free);
+}
+
 static void *
 aiger_default_malloc (void *state, size_t bytes)
 {
   return malloc (bytes);
 }
 
+static void *
+aiger_default_realloc (void *state, void *ptr,
+		       size_t old_bytes, size_t new_bytes)
+{
+  return realloc (ptr, new_bytes);
+}
+
 static void
 aiger_default_free (void *state, void *ptr, size_t bytes)
 {
@@ -243,7 +409,129 @@ aiger_default_free (void *state, void *ptr, size_t bytes)
 aiger *
 aiger_init (void)
 {
-  return aiger_init_mem (0, aiger_default_malloc, aiger_default_free);
+  return aiger_init_mem_realloc (0,
+				 aiger_default_malloc,
+				 aiger_default_realloc, aiger_default_free);
+}
+
+void
+aiger_compact (aiger * public)
+{
+  IMPORT_private_FROM (public);
+  unsigned i;
+
+  assert (!aiger_error (public));
+
+  if (public->compact)
+    return;
+
+  aiger_reencode (public);
+
+  NEWN (public->rhs0s, public->num_ands);
+  NEWN (public->rhs1s, public->num_ands);
+
+  for (i = 0; i < public->num_ands; i++)
+    {
+      public->rhs0s[i] = public->ands[i].rhs0;
+      public->rhs1s[i] = public->ands[i].rhs1;
+    }
+
+  DELETEN (public->ands, private->size_ands);
+  private->size_ands = public->num_ands;
+  public->compact = 1;
+}
+
+/* Leave compact mode before any AND has been added.
+ */
+static void
+aiger_expand (aiger * public)
+{
+  IMPORT_private_FROM (public);
+
+  assert (public->compact);
+  assert (!public->num_ands);
+
+  DELETEN (public->rhs0s, private->size_ands);
+  DELETEN (public->rhs1s, private->size_ands);
+  private->size_ands = 0;
+  public->compact = 0;
+}
+
+void
+aiger_reserve (aiger * public,
+	       aiger_lit maxvar,
+	       unsigned inputs,
+	       unsigned latches,
+	       unsigned outputs,
+	       unsigned ands,
+	       unsigned bad,
+	       unsigned constraints, unsigned justice, unsigned fairness)
+{
+  IMPORT_private_FROM (public);
+
+  FIT (private->types, private->size_types, maxvar + 1);
+  FIT (public->inputs, private->size_inputs, inputs);
+  FIT (public->latches, private->size_latches, latches);
+  FIT (public->outputs, private->size_outputs, outputs);
+  if (public->compact)
+    {
+      if (private->size_ands < ands)
+	{
+	  REALLOCN (public->rhs0s, private->size_ands, ands);
+	  REALLOCN (public->rhs1s, private->size_ands, ands);
+	  private->size_ands = ands;
+	}
+    }
+  else
+    FIT (public->ands, private->size_ands, ands);
+  FIT (public->bad, private->size_bad, bad);
+  FIT (public->constraints, private->size_constraints, constraints);
+  FIT (public->justice, private->size_justice, justice);
+  FIT (public->fairness, private->size_fairness, fairness);
+}
+
+static void *
+aiger_arena_alloc (aiger_private * private, aiger_arena * arena,
+		   size_t bytes)
+{
+  aiger_arena_block *block;
+  size_t size;
+  void *res;
+
+  bytes = (bytes + sizeof (aiger_lit) - 1) & ~(sizeof (aiger_lit) - 1);
+
+  if ((size_t) (arena->end - arena->cursor) < bytes)
+    {
+      size = sizeof (*block) + bytes;
+      if (size < AIGER_ARENA_BLOCK_SIZE)
+	size = AIGER_ARENA_BLOCK_SIZE;
+
+      block = private->malloc_callback (private->memory_mgr, size);
+      block->next = arena->blocks;
+      block->size = size;
+      arena->blocks = block;
+      arena->cursor = (char *) (block + 1);
+      arena->end = (char *) block + size;
+    }
+
+  res = arena->cursor;
+  arena->cursor += bytes;
+
+  return res;
+}
+
+static void
+aiger_arena_release (aiger_private * private, aiger_arena * arena)
+{
+  aiger_arena_block *block, *next;
+
+  for (block = arena->blocks; block; block = next)
+    {
+      next = block->next;
+      private->free_callback (private->memory_mgr, block, block->size);
+    }
+
+  CLR (*arena);
 }
 
 static void
@@ -254,17 +542,25 @@ aiger_delete_str (aiger_private * private, char *str)
 }
 
 static char *
-aiger_copy_str (aiger_private * private, const char *str)
+aiger_copy_str (aiger_private * private, aiger_arena * arena,
+		const char *str)
 {
-  char *res;  if (!str)
+  size_t bytes;
+  char *res;
+
+  if (!str)
     return 0;
 
-  NEWN (res, strlen (str) + 1);
-  strcpy (res, str);
+  bytes = strlen (str) + 1;
+  res = aiger_arena_alloc (private, arena, bytes);
+  memcpy (res, str, bytes);
 
   return res;
 }
 
+/* Names are allocated in 'name_arena' or point into the 'section' and are
+ * not released individually.
+ */
 static unsigned
 aiger_delete_symbols_aux (aiger_private * private,
 			  aiger_symbol * symbols, unsigned size)
@@ -278,7 +574,6 @@ aiger_delete_symbols_aux (aiger_private * private,
       if (!s->name)
 	continue;
 
-      aiger_delete_str (private, s->name);
       s->name = 0;
       res++;
     }
@@ -286,65 +581,100 @@ aiger_delete_symbols_aux (aiger_private * private,
   return res;
 }
 
-static void
-aiger_delete_symbols (aiger_private * private,
-		      aiger_symbol * symbols, unsigned size)
-{
-  aiger_delete_symbols_aux (private, symbols, size);
-  DELETEN (symbols, size);
-}
-
 static unsigned
 aiger_delete_comments (aiger * public)
 {
-  char **start = (char **) public->comments, ** end, ** p;
   IMPORT_private_FROM (public);
+  unsigned res;
 
-  end = start + private->num_comments;
-  for (p = start; p < end; p++)
-    aiger_delete_str (private, *p);
+  assert (private->num_comments);
+  res = private->num_comments - 1;
 
-  private->num_comments = 0;
+  private->num_comments = 1;
   public->comments[0] = 0;
 
-  return private->num_comments;
+  aiger_arena_release (private, &private->comment_arena);
+
+  return res;
+}
+
+static void
+aiger_release_fanouts (aiger_private * private)
+{
+  aiger_fanouts *fanouts = &private->fanouts;
+
+  if (!fanouts->offsets)
+    return;
+
+  DELETEN (fanouts->offsets, fanouts->size + 1);
+  DELETEN (fanouts->targets, private->size_targets);
+  DELETEN (fanouts->levels, fanouts->size);
+  DELETEN (fanouts->reverse_levels, fanouts->size);
+  CLR (*fanouts);
 }
 
 void
 aiger_reset (aiger * public)
 {
-  unsigned i;
-
   IMPORT_private_FROM (public);
 
-  aiger_delete_symbols (private, public->inputs, private->size_inputs);
-  aiger_delete_symbols (private, public->latches, private->size_latches);
-  aiger_delete_symbols (private, public->outputs, private->size_outputs);
-  aiger_delete_symbols (private, public->bad, private->size_bad);
-  aiger_delete_symbols (private, public->constraints,
-                        private->size_constraints);
-  for (i = 0; i < public->num_justice; i++)
-    DELETEN (public->justice[i].lits, public->justice[i].size);
-  aiger_delete_symbols (private, public->justice, private->size_justice);
-  aiger_delete_symbols (private, public->fairness, private->size_fairness);
-  DELETEN (public->ands, private->size_ands);
+  DELETEN (public->inputs, private->size_inputs);
+  DELETEN (public->latches, private->size_latches);
+  DELETEN (public->outputs, private->size_outputs);
+  DELETEN (public->bad, private->size_bad);
+  DELETEN (public->constraints, private->size_constraints);
+  DELETEN (public->justice, private->size_justice);
+  DELETEN (public->fairness, private->size_fairness);
+  if (public->compact)
+    {
+      DELETEN (public->rhs0s, private->size_ands);
+      DELETEN (public->rhs1s, private->size_ands);
+    }
+  else
+    DELETEN (public->ands, private->size_ands);
 
-  aiger_delete_comments (public);
   DELETEN (public->comments, private->size_comments);
+  DELETEN (private->section.start, private->section.size);
+
+  aiger_arena_release (private, &private->name_arena);
+  aiger_arena_release (private, &private->comment_arena);
+  aiger_arena_release (private, &private->lits_arena);
 
   DELETEN (private->coi, private->size_coi);
+  aiger_release_fanouts (private);
+  DELETEN (private->symbol_table, private->size_symbol_table);
 
   DELETEN (private->types, private->size_types);
   aiger_delete_str (private, private->error);
   DELETE (private);
 }
 
+/* Forget everything cached about the model.
+ */
+static void
+aiger_invalidate (aiger_private * private)
+{
+  private->checked = 0;
+  private->coi_cached = 0;
+  private->fanouts_cached = 0;
+  private->symbol_table_cached = 0;
+}
+
+void
+aiger_changed (aiger * public)
+{
+  IMPORT_private_FROM (public);
+  aiger_invalidate (private);
+}
+
 static aiger_type *
-aiger_import_literal (aiger_private * private, unsigned lit)
+aiger_import_literal (aiger_private * private, aiger_lit lit)
 {
-  unsigned var = aiger_lit2var (lit);
+  aiger_lit var = aiger_lit2var (lit);
   EXPORT_public_FROM (private);
 
+  aiger_invalidate (private);
+
   if (var > public->maxvar)
     public->maxvar = var;
 
@@ -355,7 +685,7 @@ aiger_import_literal (aiger_private * private, unsigned lit)
 }
 
 void
-aiger_add_input (aiger * public, unsigned lit, const char *name)
+aiger_add_input (aiger * public, aiger_lit lit, const char *name)
 {
   IMPORT_private_FROM (public);
   aiger_symbol symbol;
@@ -372,19 +702,23 @@ aiger_add_input (aiger * public, unsigned lit, const char *name)
   assert (!type->latch);
   assert (!type->and);
 
+  assert (!public->compact ||
+	  (!public->num_latches && !public->num_ands &&
+	   lit == aiger_var2lit (public->num_inputs + 1)));
+
   type->input = 1;
   type->idx = public->num_inputs;
 
   CLR (symbol);
   symbol.lit = lit;
-  symbol.name = aiger_copy_str (private, name);
+  symbol.name = aiger_copy_str (private, &private->name_arena, name);
 
   PUSH (public->inputs, public->num_inputs, private->size_inputs, symbol);
 }
 
 void
 aiger_add_latch (aiger * public,
-		 unsigned lit, unsigned next, const char *name)
+		 aiger_lit lit, aiger_lit next, const char *name)
 {
   IMPORT_private_FROM (public);
   aiger_symbol symbol;
@@ -401,6 +735,10 @@ aiger_add_latch (aiger * public,
   assert (!type->latch);
   assert (!type->and);
 
+  assert (!public->compact ||
+	  (!public->num_ands &&
+	   lit == aiger_var2lit (public->num_inputs + public->num_latches + 1)));
+
   /* Warning: importing 'next' makes 'type' invalid.
    */
   type->latch = 1;
@@ -411,13 +749,13 @@ aiger_add_latch (aiger * public,
   CLR (symbol);
   symbol.lit = lit;
   symbol.next = next;
-  symbol.name = aiger_copy_str (private, name);
+  symbol.name = aiger_copy_str (private, &private->name_arena, name);
 
   PUSH (public->latches, public->num_latches, private->size_latches, symbol);
 }
 
 void
-aiger_add_reset (aiger * public, unsigned lit, unsigned reset) 
+aiger_add_reset (aiger * public, aiger_lit lit, aiger_lit reset) 
 {
   IMPORT_private_FROM (public);
   aiger_type * type;
@@ -431,79 +769,82 @@ aiger_add_reset (aiger * public, unsigned lit, unsigned reset)
 }
 
 void
-aiger_add_output (aiger * public, unsigned lit, const char *name)
+aiger_add_output (aiger * public, aiger_lit lit, const char *name)
 {
   IMPORT_private_FROM (public);
   aiger_symbol symbol;
   aiger_import_literal (private, lit);
   CLR (symbol);
   symbol.lit = lit;
-  symbol.name = aiger_copy_str (private, name);
+  symbol.name = aiger_copy_str (private, &private->name_arena, name);
   PUSH (public->outputs, public->num_outputs, private->size_outputs, symbol);
 }
 
 void
-aiger_add_bad (aiger * public, unsigned lit, const char *name)
+aiger_add_bad (aiger * public, aiger_lit lit, const char *name)
 {
   IMPORT_private_FROM (public);
   aiger_symbol symbol;
   aiger_import_literal (private, lit);
   CLR (symbol);
   symbol.lit = lit;
-  symbol.name = aiger_copy_str (private, name);
+  symbol.name = aiger_copy_str (private, &private->name_arena, name);
   PUSH (public->bad, public->num_bad, private->size_bad, symbol);
 }
 
 void
-aiger_add_constraint (aiger * public, unsigned lit, const char *name)
+aiger_add_constraint (aiger * public, aiger_lit lit, const char *name)
 {
   IMPORT_private_FROM (public);
   aiger_symbol symbol;
   aiger_import_literal (private, lit);
   CLR (symbol);
   symbol.lit = lit;
-  symbol.name = aiger_copy_str (private, name);
+  symbol.name = aiger_copy_str (private, &private->name_arena, name);
   PUSH (public->constraints, 
         public->num_constraints, private->size_constraints, symbol);
 }
 
 void
 aiger_add_justice (aiger * public, 
-                   unsigned size, unsigned * lits,
+                   unsigned size, aiger_lit * lits,
 		   const char * name)
 {
   IMPORT_private_FROM (public);
   aiger_symbol symbol;
-  unsigned i, lit;
+  aiger_lit lit;
+  unsigned i;
   CLR (symbol);
+  aiger_invalidate (private);
   symbol.size = size;
-  NEWN (symbol.lits, size);
+  symbol.lits = aiger_arena_alloc (private, &private->lits_arena,
+				   size * sizeof (aiger_lit));
   for (i = 0; i < size; i++)
     {
       lit = lits[i];
       aiger_import_literal (private, lit);
       symbol.lits[i] = lit;
     }
-  symbol.name = aiger_copy_str (private, name);
+  symbol.name = aiger_copy_str (private, &private->name_arena, name);
   PUSH (public->justice, 
         public->num_justice, private->size_justice, symbol);
 }
 
 void
-aiger_add_fairness (aiger * public, unsigned lit, const char *name)
+aiger_add_fairness (aiger * public, aiger_lit lit, const char *name)
 {
   IMPORT_private_FROM (public);
   aiger_symbol symbol;
   aiger_import_literal (private, lit);
   CLR (symbol);
   symbol.lit = lit;
-  symbol.name = aiger_copy_str (private, name);
+  symbol.name = aiger_copy_str (private, &private->name_arena, name);
   PUSH (public->fairness, 
         public->num_fairness, private->size_fairness, symbol);
 }
 
 void
-aiger_add_and (aiger * public, unsigned lhs, unsigned rhs0, unsigned rhs1)
+aiger_add_and (aiger * public, aiger_lit lhs, aiger_lit rhs0, aiger_lit rhs1)
 {
   IMPORT_private_FROM (public);
   aiger_type *type;
@@ -526,6 +867,34 @@ aiger_add_and (aiger * public, unsigned lhs, unsigned rhs0, unsigned rhs1)
   aiger_import_literal (private, rhs0);
   aiger_import_literal (private, rhs1);
 
+  if (public->compact)
+    {
+      assert (lhs == aiger_and_lhs (public, public->num_ands));
+      assert (rhs0 < lhs);
+      assert (rhs1 < lhs);
+
+      if (public->num_ands == private->size_ands)
+	{
+	  size_t old_size = private->size_ands;
+	  size_t new_size = old_size ? 2 * old_size : 1;
+	  REALLOCN (public->rhs0s, old_size, new_size);
+	  REALLOCN (public->rhs1s, old_size, new_size);
+	  private->size_ands = new_size;
+	}
+
+      if (rhs0 < rhs1)		/* keep it reencoded */
+	{
+	  aiger_lit tmp = rhs0;
+	  rhs0 = rhs1;
+	  rhs1 = tmp;
+	}
+
+      public->rhs0s[public->num_ands] = rhs0;
+      public->rhs1s[public->num_ands] = rhs1;
+      public->num_ands++;
+      return;
+    }
+
   if (public->num_ands == private->size_ands)
     ENLARGE (public->ands, private->size_ands);
 
@@ -538,20 +907,67 @@ aiger_add_and (aiger * public, unsigned lhs, unsigned rhs0, unsigned rhs1)
   public->num_ands++;
 }
 
+static void
+aiger_push_comment (aiger_private * private, char *comment)
+{
+  EXPORT_public_FROM (private);
+  char **p;
+
+  assert (private->num_comments);
+  p = public->comments + private->num_comments - 1;
+  assert (!*p);
+  *p = comment;
+  PUSH (public->comments, private->num_comments, private->size_comments, 0);
+}
+
 void
 aiger_add_comment (aiger * public, const char *comment)
 {
   IMPORT_private_FROM (public);
-  char **p;
 
   assert (!aiger_error (public));
 
   assert (!strchr (comment, '\n'));
-  assert (private->num_comments);
-  p = public->comments + private->num_comments - 1;
-  assert (!*p);
-  *p = aiger_copy_str (private, comment);
-  PUSH (public->comments, private->num_comments, private->size_comments, 0);
+  if (private->section.pending)
+    aiger_load_symbols (public);
+  aiger_push_comment (private,
+		      aiger_copy_str (private, &private->comment_arena,
+				      comment));
+}
+
+/* Numbers in error messages are printed with '%u' but passed as 'aiger_lit',
+ * which in wide mode requires to widen these conversions to '%llu'.
+ */
+static void
+aiger_format_error (aiger_private * private, char *res, const char *s, ...)
+{
+  va_list ap;
+#ifdef AIGER_WIDE
+  size_t size = 2 * strlen (s) + 1;
+  const char *p;
+  char *format, *q;
+
+  NEWN (format, size);
+  for (p = s, q = format; *p; p++)
+    {
+      *q++ = *p;
+      if (p[0] == '%' && p[1] == 'u')
+	{
+	  *q++ = 'l';
+	  *q++ = 'l';
+	}
+    }
+  *q = 0;
+#else
+  const char *format = s;
+  (void) private;
+#endif
+  va_start (ap, s);
+  vsprintf (res, format, ap);
+  va_end (ap);
+#ifdef AIGER_WIDE
+  DELETEN (format, size);
+#endif
 }
 
 static const char *
@@ -571,14 +987,14 @@ aiger_error_s (aiger_private * private, const char *s, const char *a)
 }
 
 static const char *
-aiger_error_u (aiger_private * private, const char *s, unsigned u)
+aiger_error_u (aiger_private * private, const char *s, aiger_lit u)
 {
   unsigned tmp_len, error_len;
   char *tmp;
   assert (!private->error);
   tmp_len = strlen (s) + sizeof (u) * 4 + 1;
   NEWN (tmp, tmp_len);
-  sprintf (tmp, s, u);
+  aiger_format_error (private, tmp, s, u);
   error_len = strlen (tmp) + 1;
   NEWN (private->error, error_len);
   memcpy (private->error, tmp, error_len);
@@ -587,15 +1003,15 @@ aiger_error_u (aiger_private * private, const char *s, unsigned u)
 }
 
 static const char *
-aiger_error_uu (aiger_private * private, const char *s, unsigned a,
-		unsigned b)
+aiger_error_uu (aiger_private * private, const char *s, aiger_lit a,
+		aiger_lit b)
 {
   unsigned tmp_len, error_len;
   char *tmp;
   assert (!private->error);
   tmp_len = strlen (s) + sizeof (a) * 4 + sizeof (b) * 4 + 1;
   NEWN (tmp, tmp_len);
-  sprintf (tmp, s, a, b);
+  aiger_format_error (private, tmp, s, a, b);
   error_len = strlen (tmp) + 1;
   NEWN (private->error, error_len);
   memcpy (private->error, tmp, error_len);
@@ -604,7 +1020,7 @@ aiger_error_uu (aiger_private * private, const char *s, unsigned a,
 }
 
 static const char *
-aiger_error_us (aiger_private * private, const char *s, unsigned a,
+aiger_error_us (aiger_private * private, const char *s, aiger_lit a,
 		const char * b)
 {
   unsigned tmp_len, error_len;
@@ -612,7 +1028,7 @@ aiger_error_us (aiger_private * private, const char *s, unsigned a,
   assert (!private->error);
   tmp_len = strlen (s) + sizeof (a) * 4 + strlen (b) + 1;
   NEWN (tmp, tmp_len);
-  sprintf (tmp, s, a, b);
+  aiger_format_error (private, tmp, s, a, b);
   error_len = strlen (tmp) + 1;
   NEWN (private->error, error_len);
   memcpy (private->error, tmp, error_len);
@@ -622,14 +1038,14 @@ aiger_error_us (aiger_private * private, const char *s, unsigned a,
 
 static const char *
 aiger_error_usu (aiger_private * private,
-		 const char *s, unsigned a, const char *t, unsigned b)
+		 const char *s, aiger_lit a, const char *t, aiger_lit b)
 {
   unsigned tmp_len, error_len;
   char *tmp;
   assert (!private->error);
   tmp_len = strlen (s) + strlen (t) + sizeof (a) * 4 + sizeof (b) * 4 + 1;
   NEWN (tmp, tmp_len);
-  sprintf (tmp, s, a, t, b);
+  aiger_format_error (private, tmp, s, a, t, b);
   error_len = strlen (tmp) + 1;
   NEWN (private->error, error_len);
   memcpy (private->error, tmp, error_len);
@@ -645,9 +1061,9 @@ aiger_error (aiger const * public)
 }
 
 static int
-aiger_literal_defined (aiger_private * private, unsigned lit)
+aiger_literal_defined (aiger_private * private, aiger_lit lit)
 {
-  unsigned var = aiger_lit2var (lit);
+  aiger_lit var = aiger_lit2var (lit);
 #ifndef NDEBUG
   EXPORT_public_FROM (private);
 #endif
@@ -666,8 +1082,9 @@ static void
 aiger_check_next_defined (aiger_private * private)
 {
   EXPORT_public_FROM (private);
-  unsigned i, next, latch;
+  aiger_lit next, latch;
   aiger_symbol *symbol;
+  unsigned i;
 
   if (private->error)
     return;
@@ -689,22 +1106,21 @@ aiger_check_next_defined (aiger_private * private)
 }
 
 static void
-aiger_check_right_hand_side_defined (aiger_private * private, aiger_and * and,
-				     unsigned rhs)
+aiger_check_right_hand_side_defined (aiger_private * private, aiger_lit lhs,
+				     aiger_lit rhs)
 {
   if (private->error)
     return;
 
-  assert (and);
   if (!aiger_literal_defined (private, rhs))
-    aiger_error_uu (private, "literal %u in AND %u undefined", rhs, and->lhs);
+    aiger_error_uu (private, "literal %u in AND %u undefined", rhs, lhs);
 }
 
 static void
 aiger_check_right_hand_sides_defined (aiger_private * private)
 {
   EXPORT_public_FROM (private);
-  aiger_and *and;
+  aiger_lit lhs;
   unsigned i;
 
   if (private->error)
@@ -712,9 +1128,11 @@ aiger_check_right_hand_sides_defined (aiger_private * private)
 
   for (i = 0; !private->error && i < public->num_ands; i++)
     {
-      and = public->ands + i;
-      aiger_check_right_hand_side_defined (private, and, and->rhs0);
-      aiger_check_right_hand_side_defined (private, and, and->rhs1);
+      lhs = aiger_and_lhs (public, i);
+      aiger_check_right_hand_side_defined (private, lhs,
+					   aiger_and_rhs0 (public, i));
+      aiger_check_right_hand_side_defined (private, lhs,
+					   aiger_and_rhs1 (public, i));
     }
 }
 
@@ -722,7 +1140,8 @@ static void
 aiger_check_outputs_defined (aiger_private * private)
 {
   EXPORT_public_FROM (private);
-  unsigned i, output;
+  aiger_lit output;
+  unsigned i;
 
   if (private->error)
     return;
@@ -743,7 +1162,8 @@ static void
 aiger_check_bad_defined (aiger_private * private)
 {
   EXPORT_public_FROM (private);
-  unsigned i, bad;
+  aiger_lit bad;
+  unsigned i;
 
   if (private->error)
     return;
@@ -764,7 +1184,8 @@ static void
 aiger_check_constraints_defined (aiger_private * private)
 {
   EXPORT_public_FROM (private);
-  unsigned i, constraint;
+  aiger_lit constraint;
+  unsigned i;
 
   if (private->error)
     return;
@@ -785,7 +1206,8 @@ static void
 aiger_check_fairness_defined (aiger_private * private)
 {
   EXPORT_public_FROM (private);
-  unsigned i, fairness;
+  aiger_lit fairness;
+  unsigned i;
 
   if (private->error)
     return;
@@ -806,7 +1228,8 @@ static void
 aiger_check_justice_defined (aiger_private * private) 
 {
   EXPORT_public_FROM (private);
-  unsigned i, j, justice;
+  aiger_lit justice;
+  unsigned i, j;
 
   if (private->error)
     return;
@@ -826,17 +1249,40 @@ aiger_check_justice_defined (aiger_private * private)
     }
 }
 
+/* Sufficient condition for acyclicity checked in linear time, which holds
+ * for instance for all binary models.
+ */
+static int
+aiger_right_hand_sides_smaller (aiger * public)
+{
+  aiger_lit lhs;
+  unsigned i;
+
+  for (i = 0; i < public->num_ands; i++)
+    {
+      lhs = aiger_strip (aiger_and_lhs (public, i));
+      if (aiger_strip (aiger_and_rhs0 (public, i)) >= lhs)
+	return 0;
+      if (aiger_strip (aiger_and_rhs1 (public, i)) >= lhs)
+	return 0;
+    }
+
+  return 1;
+}
+
 static void
 aiger_check_for_cycles (aiger_private * private)
 {
-  unsigned i, j, *stack, size_stack, top_stack, tmp;
+  aiger_lit i, j, *stack, size_stack, top_stack, tmp;
   EXPORT_public_FROM (private);
   aiger_type *type;
-  aiger_and *and;
 
   if (private->error)
     return;
 
+  if (aiger_right_hand_sides_smaller (public))
+    return;
+
   stack = 0;
   size_stack = top_stack = 0;
 
@@ -875,13 +1321,12 @@ aiger_check_for_cycles (aiger_private * private)
 	      PUSH (stack, top_stack, size_stack, 0);
 
 	      assert (type->idx < public->num_ands);
-	      and = public->ands + type->idx;
 
-	      tmp = aiger_lit2var (and->rhs0);
+	      tmp = aiger_lit2var (aiger_and_rhs0 (public, type->idx));
 	      if (tmp)
 		PUSH (stack, top_stack, size_stack, tmp);
 
-	      tmp = aiger_lit2var (and->rhs1);
+	      tmp = aiger_lit2var (aiger_and_rhs1 (public, type->idx));
 	      if (tmp)
 		PUSH (stack, top_stack, size_stack, tmp);
 	    }
@@ -901,6 +1346,15 @@ aiger_check_for_cycles (aiger_private * private)
 	}
     }
 
+  /* Clear marks for checking again after changes.
+   */
+  for (i = 1; i <= public->maxvar; i++)
+    {
+      type = private->types + i;
+      type->mark = 0;
+      type->onstack = 0;
+    }
+
   DELETEN (stack, size_stack);
 }
 
@@ -911,6 +1365,9 @@ aiger_check (aiger * public)
 
   assert (!aiger_error (public));
 
+  if (private->checked)
+    return 0;
+
   aiger_check_next_defined (private);
   aiger_check_outputs_defined (private);
   aiger_check_bad_defined (private);
@@ -920,141 +1377,304 @@ aiger_check (aiger * public)
   aiger_check_right_hand_sides_defined (private);
   aiger_check_for_cycles (private);
 
+  private->checked = !private->error;
+
   return private->error;
 }
 
-static int
-aiger_default_get (FILE * file)
+static size_t
+aiger_file_get_block (char *buffer, size_t size, FILE * file)
 {
-  return getc (file);
+  return fread (buffer, 1, size, file);
 }
 
-static int
-aiger_string_get (const char **str)
+static size_t
+aiger_string_get_block (char *buffer, size_t size, const char **str)
 {
-    char c = **str;
-
-    if (c == '\0')
-        return EOF;
-
-    ++*str;
-    return c;
+  size_t res = strnlen (*str, size);
+  memcpy (buffer, *str, res);
+  *str += res;
+  return res;
 }
 
-static int
-aiger_default_put (char ch, FILE * file)
+static size_t
+aiger_file_put_block (const char *buffer, size_t size, FILE * file)
 {
-  return putc ((unsigned char) ch, file);
+  return fwrite (buffer, 1, size, file);
 }
 
-static int
-aiger_string_put (char ch, aiger_buffer * buffer)
+static size_t
+aiger_string_put_block (const char *buffer, size_t size,
+                        aiger_buffer * string)
 {
-  if (buffer->cursor == buffer->end)
-    return EOF;
-  *buffer->cursor++ = ch;
-  return ch;
+  if ((size_t) (string->end - string->cursor) < size)
+    return 0;
+  memcpy (string->cursor, buffer, size);
+  string->cursor += size;
+  return size;
 }
 
+/* Flush the block buffer of the writer.  Returns zero on failure.
+ */
 static int
-aiger_put_s (void *state, aiger_put put, const char *str)
+aiger_writer_flush (aiger_writer * writer)
 {
-  const char *p;
-  char ch;
+  size_t bytes;
 
-  for (p = str; (ch = *p); p++)
-    if (put (ch, state) == EOF)
+  assert (writer->put_block);
+
+  bytes = writer->cursor - writer->block;
+  writer->cursor = writer->block;
+
+  if (!bytes)
+    return 1;
+
+  return writer->put_block (writer->block, bytes, writer->state) == bytes;
+}
+
+static void
+aiger_init_block_writer (aiger_private * private, aiger_writer * writer,
+			 void *state, aiger_put_block put_block)
+{
+  CLR (*writer);
+  writer->state = state;
+  writer->put_block = put_block;
+  writer->threads = private->write_threads;
+  NEWN (writer->block, AIGER_BLOCK_SIZE);
+  writer->cursor = writer->block;
+}
+
+/* Flushes the remaining buffered bytes if 'res' is non zero and releases
+ * the buffer.  Returns zero on failure.
+ */
+static int
+aiger_release_block_writer (aiger_private * private, aiger_writer * writer,
+			    int res)
+{
+  if (res)
+    res = aiger_writer_flush (writer);
+
+  DELETEN (writer->block, AIGER_BLOCK_SIZE);
+
+  return res;
+}
+
+/* Same semantics as 'putc', e.g., returns 'EOF' on failure.
+ */
+static int
+aiger_writer_put (aiger_writer * writer, char ch)
+{
+  if (!writer->put_block)
+    return writer->put (ch, writer->state);
+
+  if (writer->cursor == writer->block + AIGER_BLOCK_SIZE &&
+      !aiger_writer_flush (writer))
+    return EOF;
+
+  *writer->cursor++ = ch;
+
+  return (unsigned char) ch;
+}
+
+static int
+aiger_put_s (aiger_writer * writer, const char *str)
+{
+  const char *p;
+  size_t bytes;
+  char ch;
+
+  if (writer->put_block)
+    {
+      bytes = strlen (str);
+      if (bytes > (size_t) (writer->block + AIGER_BLOCK_SIZE - writer->cursor)
+	  && !aiger_writer_flush (writer))
+	return EOF;
+
+      if (bytes <= AIGER_BLOCK_SIZE)
+	{
+	  memcpy (writer->cursor, str, bytes);
+	  writer->cursor += bytes;
+	}
+      else if (writer->put_block (str, bytes, writer->state) != bytes)
+	return EOF;
+
+      return bytes;
+    }
+
+  for (p = str; (ch = *p); p++)
+    if (aiger_writer_put (writer, ch) == EOF)
       return EOF;
 
   return p - str;		/* 'fputs' semantics, >= 0 is OK */
 }
 
 static int
-aiger_put_u (void *state, aiger_put put, unsigned u)
+aiger_put_u (aiger_writer * writer, aiger_lit u)
 {
   char buffer[sizeof (u) * 4];
-  sprintf (buffer, "%u", u);
-  return aiger_put_s (state, put, buffer);
+  sprintf (buffer, "%" AIGER_LIT_FMT, u);
+  return aiger_put_s (writer, buffer);
+}
+
+/* Maximum number of bytes of an encoded delta, i.e., 5 or 10 in wide mode.
+ */
+#define AIGER_MAX_DELTA_BYTES ((int) ((8 * sizeof (aiger_lit) + 6) / 7))
+
+/* The last byte of a delta with 'AIGER_MAX_DELTA_BYTES' bytes has to be
+ * smaller, i.e., 16 or 2 in wide mode.
+ */
+#define AIGER_LAST_DELTA_BYTE_LIMIT \
+  (1u << (8 * sizeof (aiger_lit) - 7 * (AIGER_MAX_DELTA_BYTES - 1)))
+
+/* Encode 'delta' at 'p' (at most 'AIGER_MAX_DELTA_BYTES') and return the
+ * end.
+ */
+static char *
+aiger_encode_delta (char *p, aiger_lit delta)
+{
+  if (delta < 0x80)
+    *p++ = delta;
+  else
+    {
+      while (delta & ~0x7f)
+	{
+	  *p++ = (delta & 0x7f) | 0x80;
+	  delta >>= 7;
+	}
+      *p++ = delta;
+    }
+  return p;
+}
+
+/* Number of bytes of an encoded delta.
+ */
+static size_t
+aiger_delta_bytes (aiger_lit delta)
+{
+  size_t res = 5;
+  if (delta < (1u << 7)) return 1;
+  if (delta < (1u << 14)) return 2;
+  if (delta < (1u << 21)) return 3;
+  if (delta < (1u << 28)) return 4;
+#ifdef AIGER_WIDE
+  for (delta >>= 35; delta; delta >>= 7)
+    res++;
+#endif
+  return res;
 }
 
 static int
-aiger_write_delta (void *state, aiger_put put, unsigned delta)
+aiger_write_delta (aiger_writer * writer, aiger_lit delta)
 {
   unsigned char ch;
-  unsigned tmp = delta;
+  aiger_lit tmp = delta;
+
+  if (writer->put_block)
+    {
+      /* Encode directly into the block buffer.
+       */
+      if (writer->block + AIGER_BLOCK_SIZE - writer->cursor <
+	  AIGER_MAX_DELTA_BYTES &&
+	  !aiger_writer_flush (writer))
+	return 0;
+
+      writer->cursor = aiger_encode_delta (writer->cursor, delta);
+
+      return 1;
+    }
 
   while (tmp & ~0x7f)
     {
       ch = tmp & 0x7f;
       ch |= 0x80;
 
-      if (put (ch, state) == EOF)
+      if (aiger_writer_put (writer, ch) == EOF)
 	return 0;
 
       tmp >>= 7;
     }
 
   ch = tmp;
-  return put (ch, state) != EOF;
+  return aiger_writer_put (writer, ch) != EOF;
 }
 
 static int
-aiger_write_header (aiger * public,
-		    const char *format_string,
-		    int compact_inputs_and_latches,
-		    void *state, aiger_put put)
+aiger_write_header_line (aiger_writer * writer,
+			 const char *format_string,
+			 const aiger_header * header)
 {
-  unsigned i, j;
-
-  if (aiger_put_s (state, put, format_string) == EOF) return 0;
-  if (put (' ', state) == EOF) return 0;
-  if (aiger_put_u (state, put, public->maxvar) == EOF) return 0;
-  if (put (' ', state) == EOF) return 0;
-  if (aiger_put_u (state, put, public->num_inputs) == EOF) return 0;
-  if (put (' ', state) == EOF) return 0;
-  if (aiger_put_u (state, put, public->num_latches) == EOF) return 0;
-  if (put (' ', state) == EOF) return 0;
-  if (aiger_put_u (state, put, public->num_outputs) == EOF) return 0;
-  if (put (' ', state) == EOF) return 0;
-  if (aiger_put_u (state, put, public->num_ands) == EOF) return 0;
-
-  if (public->num_bad ||
-      public->num_constraints ||
-      public->num_justice ||
-      public->num_fairness)
+  if (aiger_put_s (writer, format_string) == EOF) return 0;
+  if (aiger_writer_put (writer, ' ') == EOF) return 0;
+  if (aiger_put_u (writer, header->maxvar) == EOF) return 0;
+  if (aiger_writer_put (writer, ' ') == EOF) return 0;
+  if (aiger_put_u (writer, header->inputs) == EOF) return 0;
+  if (aiger_writer_put (writer, ' ') == EOF) return 0;
+  if (aiger_put_u (writer, header->latches) == EOF) return 0;
+  if (aiger_writer_put (writer, ' ') == EOF) return 0;
+  if (aiger_put_u (writer, header->outputs) == EOF) return 0;
+  if (aiger_writer_put (writer, ' ') == EOF) return 0;
+  if (aiger_put_u (writer, header->ands) == EOF) return 0;
+
+  if (header->bad ||
+      header->constraints ||
+      header->justice ||
+      header->fairness)
     {
-      if (put (' ', state) == EOF) return 0;
-      if (aiger_put_u (state, put, public->num_bad) == EOF) return 0;
+      if (aiger_writer_put (writer, ' ') == EOF) return 0;
+      if (aiger_put_u (writer, header->bad) == EOF) return 0;
     }
 
-  if (public->num_constraints ||
-      public->num_justice ||
-      public->num_fairness)
+  if (header->constraints ||
+      header->justice ||
+      header->fairness)
     {
-      if (put (' ', state) == EOF) return 0;
-      if (aiger_put_u (state, put, public->num_constraints) == EOF) return 0;
+      if (aiger_writer_put (writer, ' ') == EOF) return 0;
+      if (aiger_put_u (writer, header->constraints) == EOF) return 0;
     }
 
-  if (public->num_justice ||
-      public->num_fairness)
+  if (header->justice ||
+      header->fairness)
     {
-      if (put (' ', state) == EOF) return 0;
-      if (aiger_put_u (state, put, public->num_justice) == EOF) return 0;
+      if (aiger_writer_put (writer, ' ') == EOF) return 0;
+      if (aiger_put_u (writer, header->justice) == EOF) return 0;
     }
 
-  if (public->num_fairness)
+  if (header->fairness)
     {
-      if (put (' ', state) == EOF) return 0;
-      if (aiger_put_u (state, put, public->num_fairness) == EOF) return 0;
+      if (aiger_writer_put (writer, ' ') == EOF) return 0;
+      if (aiger_put_u (writer, header->fairness) == EOF) return 0;
     }
 
-  if (put ('\n', state) == EOF) return 0;
+  return aiger_writer_put (writer, '\n') != EOF;
+}
+
+static int
+aiger_write_header (aiger * public,
+		    const char *format_string,
+		    int compact_inputs_and_latches,
+		    aiger_writer * writer)
+{
+  aiger_header header;
+  unsigned i, j;
+
+  header.maxvar = public->maxvar;
+  header.inputs = public->num_inputs;
+  header.latches = public->num_latches;
+  header.outputs = public->num_outputs;
+  header.ands = public->num_ands;
+  header.bad = public->num_bad;
+  header.constraints = public->num_constraints;
+  header.justice = public->num_justice;
+  header.fairness = public->num_fairness;
+
+  if (!aiger_write_header_line (writer, format_string, &header))
+    return 0;
 
   if (!compact_inputs_and_latches && public->num_inputs)
     {
       for (i = 0; i < public->num_inputs; i++)
-	if (aiger_put_u (state, put, public->inputs[i].lit) == EOF ||
-	    put ('\n', state) == EOF)
+	if (aiger_put_u (writer, public->inputs[i].lit) == EOF ||
+	    aiger_writer_put (writer, '\n') == EOF)
 	  return 0;
     }
 
@@ -1064,45 +1684,45 @@ aiger_write_header (aiger * public,
 	{
 	  if (!compact_inputs_and_latches)
 	    {
-	      if (aiger_put_u (state, put, public->latches[i].lit) == EOF)
+	      if (aiger_put_u (writer, public->latches[i].lit) == EOF)
 	        return 0;
-	      if (put (' ', state) == EOF) return 0;
+	      if (aiger_writer_put (writer, ' ') == EOF) return 0;
 	    }
 
-	  if (aiger_put_u (state, put, public->latches[i].next) == EOF)
+	  if (aiger_put_u (writer, public->latches[i].next) == EOF)
 	     return 0;
 
 	  if (public->latches[i].reset) 
 	    {
-	      if (put (' ', state) == EOF) return 0;
-	      if (aiger_put_u (state, put, public->latches[i].reset) == EOF)
+	      if (aiger_writer_put (writer, ' ') == EOF) return 0;
+	      if (aiger_put_u (writer, public->latches[i].reset) == EOF)
 		return 0;
 	    }
-	  if (put ('\n', state) == EOF) return 0;
+	  if (aiger_writer_put (writer, '\n') == EOF) return 0;
 	}
     }
 
   if (public->num_outputs)
     {
       for (i = 0; i < public->num_outputs; i++)
-	if (aiger_put_u (state, put, public->outputs[i].lit) == EOF ||
-	    put ('\n', state) == EOF)
+	if (aiger_put_u (writer, public->outputs[i].lit) == EOF ||
+	    aiger_writer_put (writer, '\n') == EOF)
 	  return 0;
     }
 
   if (public->num_bad)
     {
       for (i = 0; i < public->num_bad; i++)
-	if (aiger_put_u (state, put, public->bad[i].lit) == EOF ||
-	    put ('\n', state) == EOF)
+	if (aiger_put_u (writer, public->bad[i].lit) == EOF ||
+	    aiger_writer_put (writer, '\n') == EOF)
 	  return 0;
     }
 
   if (public->num_constraints)
     {
       for (i = 0; i < public->num_constraints; i++)
-	if (aiger_put_u (state, put, public->constraints[i].lit) == EOF ||
-	    put ('\n', state) == EOF)
+	if (aiger_put_u (writer, public->constraints[i].lit) == EOF ||
+	    aiger_writer_put (writer, '\n') == EOF)
 	  return 0;
     }
 
@@ -1110,18 +1730,18 @@ aiger_write_header (aiger * public,
     {
       for (i = 0; i < public->num_justice; i++)
 	{
-	  if (aiger_put_u (state, put, public->justice[i].size) == EOF)
+	  if (aiger_put_u (writer, public->justice[i].size) == EOF)
 	    return 0;
-	  if (put ('\n', state) == EOF) return 0;
+	  if (aiger_writer_put (writer, '\n') == EOF) return 0;
 	}
 
       for (i = 0; i < public->num_justice; i++)
 	{
 	  for (j = 0; j < public->justice[i].size; j++)
 	    {
-	      if (aiger_put_u (state, put, public->justice[i].lits[j]) == EOF)
+	      if (aiger_put_u (writer, public->justice[i].lits[j]) == EOF)
 	        return 0;
-	      if (put ('\n', state) == EOF) return 0;
+	      if (aiger_writer_put (writer, '\n') == EOF) return 0;
 	    }
 	}
     }
@@ -1129,8 +1749,8 @@ aiger_write_header (aiger * public,
   if (public->num_fairness)
     {
       for (i = 0; i < public->num_fairness; i++)
-	if (aiger_put_u (state, put, public->fairness[i].lit) == EOF ||
-	    put ('\n', state) == EOF)
+	if (aiger_put_u (writer, public->fairness[i].lit) == EOF ||
+	    aiger_writer_put (writer, '\n') == EOF)
 	  return 0;
     }
 
@@ -1192,7 +1812,7 @@ aiger_have_at_least_one_symbol (aiger * public)
 
 static int
 aiger_write_symbols_aux (aiger * public,
-			 void *state, aiger_put put,
+			 aiger_writer * writer,
 			 const char *type,
 			 aiger_symbol * symbols, unsigned size)
 {
@@ -1203,11 +1823,11 @@ aiger_write_symbols_aux (aiger * public,
       if (!symbols[i].name)
 	continue;
 
-      if (aiger_put_s (state, put, type) == EOF ||
-	  aiger_put_u (state, put, i) == EOF ||
-	  put (' ', state) == EOF ||
-	  aiger_put_s (state, put, symbols[i].name) == EOF ||
-	  put ('\n', state) == EOF)
+      if (aiger_put_s (writer, type) == EOF ||
+	  aiger_put_u (writer, i) == EOF ||
+	  aiger_writer_put (writer, ' ') == EOF ||
+	  aiger_put_s (writer, symbols[i].name) == EOF ||
+	  aiger_writer_put (writer, '\n') == EOF)
 	return 0;
     }
 
@@ -1215,34 +1835,34 @@ aiger_write_symbols_aux (aiger * public,
 }
 
 static int
-aiger_write_symbols (aiger * public, void *state, aiger_put put)
+aiger_write_symbols (aiger * public, aiger_writer * writer)
 {
-  if (!aiger_write_symbols_aux (public, state, put,
+  if (!aiger_write_symbols_aux (public, writer,
 				"i", public->inputs, public->num_inputs))
     return 0;
 
-  if (!aiger_write_symbols_aux (public, state, put,
+  if (!aiger_write_symbols_aux (public, writer,
 				"l", public->latches, public->num_latches))
     return 0;
 
-  if (!aiger_write_symbols_aux (public, state, put,
+  if (!aiger_write_symbols_aux (public, writer,
 				"o", public->outputs, public->num_outputs))
     return 0;
 
-  if (!aiger_write_symbols_aux (public, state, put,
+  if (!aiger_write_symbols_aux (public, writer,
 				"b", public->bad, public->num_bad))
     return 0;
 
-  if (!aiger_write_symbols_aux (public, state, put,
+  if (!aiger_write_symbols_aux (public, writer,
 				"c", public->constraints,
 				public->num_constraints))
     return 0;
 
-  if (!aiger_write_symbols_aux (public, state, put,
+  if (!aiger_write_symbols_aux (public, writer,
 				"j", public->justice, public->num_justice))
     return 0;
 
-  if (!aiger_write_symbols_aux (public, state, put,
+  if (!aiger_write_symbols_aux (public, writer,
 				"f", public->fairness, public->num_fairness))
     return 0;
 
@@ -1252,21 +1872,33 @@ aiger_write_symbols (aiger * public, void *state, aiger_put put)
 int
 aiger_write_symbols_to_file (aiger * public, FILE * file)
 {
+  IMPORT_private_FROM (public);
+  aiger_writer writer;
+  int res;
+
   assert (!aiger_error (public));
-  return aiger_write_symbols (public, file, (aiger_put) aiger_default_put);
+
+  if (aiger_load_symbols (public))
+    return 0;
+
+  aiger_init_block_writer (private, &writer,
+			   file, (aiger_put_block) aiger_file_put_block);
+  res = aiger_write_symbols (public, &writer);
+
+  return aiger_release_block_writer (private, &writer, res);
 }
 
 static int
-aiger_write_comments (aiger * public, void *state, aiger_put put)
+aiger_write_comments (aiger * public, aiger_writer * writer)
 {
   char **p, *str;
 
   for (p = public->comments; (str = *p); p++)
     {
-      if (aiger_put_s (state, put, str) == EOF)
+      if (aiger_put_s (writer, str) == EOF)
 	return 0;
 
-      if (put ('\n', state) == EOF)
+      if (aiger_writer_put (writer, '\n') == EOF)
 	return 0;
     }
 
@@ -1276,40 +1908,51 @@ aiger_write_comments (aiger * public, void *state, aiger_put put)
 int
 aiger_write_comments_to_file (aiger * public, FILE * file)
 {
+  IMPORT_private_FROM (public);
+  aiger_writer writer;
+  int res;
+
   assert (!aiger_error (public));
-  return aiger_write_comments (public, file, (aiger_put) aiger_default_put);
+
+  if (aiger_load_symbols (public))
+    return 0;
+
+  aiger_init_block_writer (private, &writer,
+			   file, (aiger_put_block) aiger_file_put_block);
+  res = aiger_write_comments (public, &writer);
+
+  return aiger_release_block_writer (private, &writer, res);
 }
 
 static int
-aiger_write_ascii (aiger * public, void *state, aiger_put put)
+aiger_write_ascii (aiger * public, aiger_writer * writer)
 {
-  aiger_and *and;
   unsigned i;
 
   assert (!aiger_check (public));
 
-  if (!aiger_write_header (public, "aag", 0, state, put))
+  if (!aiger_write_header (public, "aag", 0, writer))
     return 0;
 
   for (i = 0; i < public->num_ands; i++)
     {
-      and = public->ands + i;
-      if (aiger_put_u (state, put, and->lhs) == EOF ||
-	  put (' ', state) == EOF ||
-	  aiger_put_u (state, put, and->rhs0) == EOF ||
-	  put (' ', state) == EOF ||
-	  aiger_put_u (state, put, and->rhs1) == EOF ||
-	  put ('\n', state) == EOF)
+      if (aiger_put_u (writer, aiger_and_lhs (public, i)) == EOF ||
+	  aiger_writer_put (writer, ' ') == EOF ||
+	  aiger_put_u (writer, aiger_and_rhs0 (public, i)) == EOF ||
+	  aiger_writer_put (writer, ' ') == EOF ||
+	  aiger_put_u (writer, aiger_and_rhs1 (public, i)) == EOF ||
+	  aiger_writer_put (writer, '\n') == EOF)
 	return 0;
     }
 
   return 1;
 }
 
-static unsigned
+static aiger_lit
 aiger_max_input_or_latch (aiger const * public)
 {
-  unsigned i, tmp, res;
+  aiger_lit tmp, res;
+  unsigned i;
 
   res = 0;
 
@@ -1335,8 +1978,11 @@ aiger_max_input_or_latch (aiger const * public)
 int
 aiger_is_reencoded (aiger const * public)
 {
-  unsigned i, tmp, max, lhs;
-  aiger_and *and;
+  aiger_lit tmp, max, lhs, rhs0, rhs1;
+  unsigned i;
+
+  if (public->compact)
+    return 1;			/* invariant of compact mode */
 
   max = 0;
   for (i = 0; i < public->num_inputs; i++)
@@ -1358,18 +2004,20 @@ aiger_is_reencoded (aiger const * public)
   lhs = aiger_max_input_or_latch (public) + 2;
   for (i = 0; i < public->num_ands; i++)
     {
-      and = public->ands + i;
+      tmp = aiger_and_lhs (public, i);
+      rhs0 = aiger_and_rhs0 (public, i);
+      rhs1 = aiger_and_rhs1 (public, i);
 
-      if (and->lhs <= max)
+      if (tmp <= max)
 	return 0;
 
-      if (and->lhs != lhs)
+      if (tmp != lhs)
 	return 0;
 
-      if (and->lhs < and->rhs0)
+      if (tmp < rhs0)
 	return 0;
 
-      if (and->rhs0 < and->rhs1)
+      if (rhs0 < rhs1)
 	return 0;
 
       lhs += 2;
@@ -1379,9 +2027,9 @@ aiger_is_reencoded (aiger const * public)
 }
 
 static void
-aiger_new_code (unsigned var, unsigned *new, unsigned *code)
+aiger_new_code (aiger_lit var, aiger_lit *new, aiger_lit *code)
 {
-  unsigned lit = aiger_var2lit (var), res;
+  aiger_lit lit = aiger_var2lit (var), res;
   assert (!code[lit]);
   res = *new;
   code[lit] = res;
@@ -1389,12 +2037,12 @@ aiger_new_code (unsigned var, unsigned *new, unsigned *code)
   *new += 2;
 }
 
-static unsigned
-aiger_reencode_lit (aiger * public, unsigned lit,
-		    unsigned *new, unsigned *code,
-		    unsigned **stack_ptr, unsigned * size_stack_ptr)
+static aiger_lit
+aiger_reencode_lit (aiger * public, aiger_lit lit,
+		    aiger_lit *new, aiger_lit *code,
+		    aiger_lit **stack_ptr, aiger_lit * size_stack_ptr)
 {
-  unsigned res, old, top, child0, child1, tmp, var, size_stack, * stack;
+  aiger_lit res, old, top, child0, child1, tmp, var, size_stack, * stack;
   IMPORT_private_FROM (public);
   aiger_type *type;
   aiger_and *and;
@@ -1495,20 +2143,104 @@ aiger_reencode_lit (aiger * public, unsigned lit,
   return code[lit];
 }
 
+/* Non zero if every AND only refers to inputs, latches and ANDs stored
+ * before it in 'public->ands', even if there are holes in the variables.
+ */
 static int
-cmp_lhs (const void *a, const void *b)
+aiger_ands_in_topological_order (aiger * public)
+{
+  IMPORT_private_FROM (public);
+  aiger_type *type;
+  aiger_and *and;
+  unsigned i;
+
+  for (i = 0; i < public->num_ands; i++)
+    {
+      and = public->ands + i;
+
+      type = private->types + aiger_lit2var (and->rhs0);
+      if (type->and && type->idx >= i)
+	return 0;
+
+      type = private->types + aiger_lit2var (and->rhs1);
+      if (type->and && type->idx >= i)
+	return 0;
+    }
+
+  return 1;
+}
+
+static void
+aiger_keep_and (aiger * public, unsigned char *keep, aiger_lit lit)
+{
+  IMPORT_private_FROM (public);
+  aiger_type *type = private->types + aiger_lit2var (lit);
+  if (type->and)
+    keep[type->idx] = 1;
+}
+
+/* If the ANDs are already in topological order, the ANDs in the cone of
+ * the roots are found in one backward sweep and keep their relative order.
+ * All codes are assigned up front, so 'aiger_reencode_lit' only looks them
+ * up and does not need its stack.
+ */
+static void
+aiger_reencode_in_order (aiger * public, aiger_lit *new, aiger_lit *code)
 {
-  const aiger_and *c = a;
-  const aiger_and *d = b;
-  return ((int) c->lhs) - (int) d->lhs;
+  IMPORT_private_FROM (public);
+  unsigned char *keep;
+  aiger_and *and;
+  unsigned i, j;
+
+  NEWN (keep, public->num_ands);
+
+  for (i = 0; i < public->num_latches; i++)
+    {
+      aiger_keep_and (public, keep, public->latches[i].next);
+      aiger_keep_and (public, keep, public->latches[i].reset);
+    }
+
+  for (i = 0; i < public->num_outputs; i++)
+    aiger_keep_and (public, keep, public->outputs[i].lit);
+
+  for (i = 0; i < public->num_bad; i++)
+    aiger_keep_and (public, keep, public->bad[i].lit);
+
+  for (i = 0; i < public->num_constraints; i++)
+    aiger_keep_and (public, keep, public->constraints[i].lit);
+
+  for (i = 0; i < public->num_justice; i++)
+    for (j = 0; j < public->justice[i].size; j++)
+      aiger_keep_and (public, keep, public->justice[i].lits[j]);
+
+  for (i = 0; i < public->num_fairness; i++)
+    aiger_keep_and (public, keep, public->fairness[i].lit);
+
+  i = public->num_ands;
+  while (i-- > 0)
+    {
+      if (!keep[i])
+	continue;
+
+      and = public->ands + i;
+      aiger_keep_and (public, keep, and->rhs0);
+      aiger_keep_and (public, keep, and->rhs1);
+    }
+
+  for (i = 0; i < public->num_ands; i++)
+    if (keep[i])
+      aiger_new_code (aiger_lit2var (public->ands[i].lhs), new, code);
+
+  DELETEN (keep, public->num_ands);
 }
 
 void
 aiger_reencode (aiger * public)
 {
-  unsigned *code, i, j, size_code, old, new, lhs, rhs0, rhs1, tmp;
-  unsigned *stack, size_stack;
+  aiger_lit *code, i, j, k, size_code, old, new, lhs, rhs0, rhs1, tmp;
+  aiger_lit *stack, size_stack;
   IMPORT_private_FROM (public);
+  aiger_and swap;
 
   assert (!aiger_error (public));
 
@@ -1519,6 +2251,9 @@ aiger_reencode (aiger * public)
   if (aiger_is_reencoded (public))
     return;
 
+  assert (!public->compact);
+  aiger_invalidate (private);
+
   size_code = 2 * (public->maxvar + 1);
   if (size_code < 2)
     size_code = 2;
@@ -1549,6 +2284,9 @@ aiger_reencode (aiger * public)
       new += 2;
     }
 
+  if (aiger_ands_in_topological_order (public))
+    aiger_reencode_in_order (public, &new, code);
+
   stack = 0;
   size_stack = 0;
 
@@ -1632,7 +2370,21 @@ aiger_reencode (aiger * public)
     }
   public->num_ands = j;
 
-  qsort (public->ands, j, sizeof (*and), cmp_lhs);
+  /* The new left hand sides are dense, so every AND can be moved to its
+   * final position directly.  Each swap places at least one of them.
+   */
+  lhs = 2 * ((aiger_lit) public->num_inputs + public->num_latches + 1);
+  for (i = 0; i < j; i++)
+    {
+      and = public->ands + i;
+      while ((k = (and->lhs - lhs) / 2) != i)
+	{
+	  assert (k < j);
+	  swap = public->ands[k];
+	  public->ands[k] = *and;
+	  *and = swap;
+	}
+    }
 
   /* Reset types.
    */
@@ -1697,91 +2449,516 @@ aiger_reencode (aiger * public)
   assert (!aiger_check (public));
 }
 
-const unsigned char *
-aiger_coi (aiger * public)
+static void
+aiger_coi_push (aiger * public, aiger_lit *stack, aiger_lit *top_ptr,
+		aiger_lit lit)
 {
   IMPORT_private_FROM (public);
-  private->size_coi = public->maxvar + 1;
-  NEWN (private->coi, private->size_coi);
-  memset (private->coi, 1, private->size_coi);
-  return private->coi;
+  aiger_lit var = aiger_lit2var (lit);
+
+  if (!var || var > public->maxvar || private->coi[var])
+    return;
+
+  private->coi[var] = 1;
+  stack[(*top_ptr)++] = var;
 }
 
-static int
-aiger_write_binary (aiger * public, void *state, aiger_put put)
+/* Start with a cleared 'coi' array and a stack for all variables, which is
+ * enough since every variable is pushed at most once.
+ */
+static aiger_lit *
+aiger_coi_init (aiger * public)
 {
-  aiger_and *and;
-  unsigned lhs, i;
+  IMPORT_private_FROM (public);
+  aiger_lit *stack;
 
-  assert (!aiger_check (public));
+  if (private->size_coi != public->maxvar + 1)
+    {
+      DELETEN (private->coi, private->size_coi);
+      private->size_coi = public->maxvar + 1;
+      NEWN (private->coi, private->size_coi);
+    }
+  else
+    memset (private->coi, 0, private->size_coi);
 
-  aiger_reencode (public);
+  private->coi_cached = 0;
+  NEWN (stack, private->size_coi);
 
-  if (!aiger_write_header (public, "aig", 1, state, put))
-    return 0;
+  return stack;
+}
 
-  lhs = aiger_max_input_or_latch (public) + 2;
+/* Close the roots on the stack under the AND and latch fan-in relation.
+ */
+static void
+aiger_coi_close (aiger * public, aiger_lit *stack, aiger_lit top)
+{
+  IMPORT_private_FROM (public);
+  aiger_symbol *latch;
+  aiger_type *type;
+  aiger_lit var;
 
-  for (i = 0; i < public->num_ands; i++)
+  while (top)
     {
-      and = public->ands + i;
-
-      assert (lhs == and->lhs);
-      assert (lhs > and->rhs0);
-      assert (and->rhs0 >= and->rhs1);
-
-      if (!aiger_write_delta (state, put, lhs - and->rhs0))
-	return 0;
-
-      if (!aiger_write_delta (state, put, and->rhs0 - and->rhs1))
-	return 0;
+      var = stack[--top];
+      if (var >= private->size_types)
+	continue;
 
-      lhs += 2;
+      type = private->types + var;
+      if (type->and)
+	{
+	  aiger_coi_push (public, stack, &top,
+			  aiger_and_rhs0 (public, type->idx));
+	  aiger_coi_push (public, stack, &top,
+			  aiger_and_rhs1 (public, type->idx));
+	}
+      else if (type->latch)
+	{
+	  latch = public->latches + type->idx;
+	  aiger_coi_push (public, stack, &top, latch->next);
+	  aiger_coi_push (public, stack, &top, latch->reset);
+	}
     }
 
-  return 1;
+  DELETEN (stack, private->size_coi);
 }
 
-static unsigned
-strip_symbols_and_comments (aiger * public, int symbols, int comments)
+const unsigned char *
+aiger_coi (aiger * public)
 {
   IMPORT_private_FROM (public);
-  unsigned res = 0;
+  aiger_lit *stack, top;
+  unsigned i, j;
 
-  assert (!aiger_error (public));
+  if (private->coi_cached)
+    return private->coi;
 
-  if (comments)
-    res += aiger_delete_comments (public);
+  stack = aiger_coi_init (public);
+  top = 0;
 
-  if (!symbols)
-    return res;
+  for (i = 0; i < public->num_outputs; i++)
+    aiger_coi_push (public, stack, &top, public->outputs[i].lit);
 
-  res += aiger_delete_symbols_aux (private,
-				   public->inputs,
-				   private->size_inputs);
-  res += aiger_delete_symbols_aux (private,
-				   public->latches,
-				   private->size_latches);
-  res += aiger_delete_symbols_aux (private,
-				   public->outputs,
-				   private->size_outputs);
-  res += aiger_delete_symbols_aux (private,
-				   public->bad, 
-				   private->size_bad);
-  res += aiger_delete_symbols_aux (private,
-				   public->constraints,
-				   private->size_constraints);
-  res += aiger_delete_symbols_aux (private,
-				   public->justice,
-				   private->size_justice);
-  res += aiger_delete_symbols_aux (private,
-				   public->fairness,
-				   private->size_fairness);
-  return res;
+  for (i = 0; i < public->num_bad; i++)
+    aiger_coi_push (public, stack, &top, public->bad[i].lit);
+
+  for (i = 0; i < public->num_constraints; i++)
+    aiger_coi_push (public, stack, &top, public->constraints[i].lit);
+
+  for (i = 0; i < public->num_justice; i++)
+    for (j = 0; j < public->justice[i].size; j++)
+      aiger_coi_push (public, stack, &top, public->justice[i].lits[j]);
+
+  for (i = 0; i < public->num_fairness; i++)
+    aiger_coi_push (public, stack, &top, public->fairness[i].lit);
+
+  aiger_coi_close (public, stack, top);
+  private->coi_cached = 1;
+
+  return private->coi;
 }
 
-unsigned
-aiger_strip_symbols_and_comments (aiger * public)
+const unsigned char *
+aiger_coi_of_lits (aiger * public, const aiger_lit *lits, unsigned num_lits)
+{
+  aiger_lit *stack, top;
+  unsigned i;
+
+  stack = aiger_coi_init (public);
+  top = 0;
+
+  for (i = 0; i < num_lits; i++)
+    aiger_coi_push (public, stack, &top, lits[i]);
+
+  aiger_coi_close (public, stack, top);
+
+  return ((aiger_private *) public)->coi;
+}
+
+/* The second pass fills the fanouts of each variable from the end of its
+ * range backwards, which leaves 'offsets[var]' at the start of the range.
+ * Levels are then computed in topological order and reverse levels in the
+ * opposite order.  If every AND has a larger variable than its inputs, as
+ * for instance after reencoding, the variables are already in topological
+ * order.  Otherwise it is determined by counting down the two fanin edges
+ * of each AND.
+ */
+const aiger_fanouts *
+aiger_get_fanouts (aiger * public)
+{
+  IMPORT_private_FROM (public);
+  aiger_fanouts *res = &private->fanouts;
+  aiger_lit i, var, lhs, rhs0, rhs1, size, head, tail, level;
+  aiger_lit *offsets, *targets, *order, *p, *end;
+  unsigned *pending;
+  int ordered;
+
+  if (private->fanouts_cached)
+    return res;
+
+  aiger_release_fanouts (private);
+
+  size = public->maxvar + 1;
+  res->size = size;
+  private->size_targets = 2 * (aiger_lit) public->num_ands;
+  NEWN (res->offsets, size + 1);
+  NEWN (res->targets, private->size_targets);
+  NEWN (res->levels, size);
+  NEWN (res->reverse_levels, size);
+
+  offsets = res->offsets;
+  targets = res->targets;
+
+  for (i = 0; i < public->num_ands; i++)
+    {
+      offsets[aiger_lit2var (aiger_and_rhs0 (public, i))]++;
+      offsets[aiger_lit2var (aiger_and_rhs1 (public, i))]++;
+    }
+
+  for (var = 1; var < size; var++)
+    offsets[var] += offsets[var - 1];
+  offsets[size] = offsets[size - 1];
+
+  ordered = 1;
+  i = public->num_ands;
+  while (i-- > 0)
+    {
+      lhs = aiger_and_lhs (public, i);
+      rhs0 = aiger_and_rhs0 (public, i);
+      rhs1 = aiger_and_rhs1 (public, i);
+      targets[--offsets[aiger_lit2var (rhs1)]] = lhs | aiger_sign (rhs1);
+      targets[--offsets[aiger_lit2var (rhs0)]] = lhs | aiger_sign (rhs0);
+      if (lhs <= rhs0 || lhs <= rhs1)
+	ordered = 0;
+    }
+
+  assert (!offsets[0]);
+  assert (offsets[size] == private->size_targets);
+
+  order = 0;
+
+  if (ordered)
+    {
+      for (var = 1; var < size; var++)
+	{
+	  if (!private->types[var].and)
+	    continue;
+
+	  i = private->types[var].idx;
+	  rhs0 = res->levels[aiger_lit2var (aiger_and_rhs0 (public, i))];
+	  rhs1 = res->levels[aiger_lit2var (aiger_and_rhs1 (public, i))];
+	  res->levels[var] = 1 + (rhs0 < rhs1 ? rhs1 : rhs0);
+	}
+    }
+  else
+    {
+      NEWN (order, size);
+      pending = res->reverse_levels;	/* zero again at the end */
+
+      for (i = 0; i < public->num_ands; i++)
+	pending[aiger_lit2var (aiger_and_lhs (public, i))] = 2;
+
+      tail = 0;
+      for (var = 0; var < size; var++)
+	if (!pending[var])
+	  order[tail++] = var;
+
+      for (head = 0; head < tail; head++)
+	{
+	  var = order[head];
+	  level = res->levels[var] + 1;
+	  end = targets + offsets[var + 1];
+	  for (p = targets + offsets[var]; p < end; p++)
+	    {
+	      i = aiger_lit2var (*p);
+	      if (res->levels[i] < level)
+		res->levels[i] = level;
+	      if (!--pending[i])
+		order[tail++] = i;
+	    }
+	}
+
+      assert (tail == size);	/* otherwise cyclic */
+    }
+
+  head = size;
+  while (head-- > 0)
+    {
+      var = order ? order[head] : head;
+      level = 0;
+      end = targets + offsets[var + 1];
+      for (p = targets + offsets[var]; p < end; p++)
+	{
+	  i = res->reverse_levels[aiger_lit2var (*p)] + 1;
+	  if (level < i)
+	    level = i;
+	}
+      res->reverse_levels[var] = level;
+    }
+
+  if (order)
+    DELETEN (order, size);
+
+  private->fanouts_cached = 1;
+
+  return res;
+}
+
+#ifdef AIGER_HAVE_PTHREAD
+
+/* Run 'fun' on all 'threads' chunks of 'size' bytes each, the first one in
+ * the calling thread.  Returns zero if a thread could not be started.
+ */
+static int
+aiger_run_chunks (aiger_private * private,
+		  void *chunks, size_t size, unsigned threads,
+		  void *(*fun) (void *))
+{
+  unsigned i, started;
+  pthread_t *ids;
+  int res = 1;
+
+  NEWN (ids, threads);
+
+  for (started = 1; started < threads; started++)
+    if (pthread_create (ids + started, 0, fun,
+			(char *) chunks + started * size))
+      break;
+
+  if (started < threads)
+    res = 0;
+  else
+    fun (chunks);
+
+  for (i = 1; i < started; i++)
+    pthread_join (ids[i], 0);
+
+  DELETEN (ids, threads);
+
+  return res;
+}
+
+/*------------------------------------------------------------------------*/
+/* Multi-threaded encoding of the binary AND section.  After reencoding the
+ * deltas of an AND only depend on the AND itself.  The threads first
+ * compute the exact size of their range of ANDs, which gives the offset of
+ * each range in one buffer for the whole section.  Then all ranges are
+ * encoded in parallel and the buffer is written with a single 'put_block'.
+ */
+typedef struct aiger_encoder aiger_encoder;
+
+struct aiger_encoder
+{
+  aiger *public;
+  unsigned begin_and, end_and;	/* gate range [begin_and..end_and[ */
+  size_t bytes;			/* encoded size of the range */
+  char *start;			/* where to encode the range */
+};
+
+static void *
+aiger_size_chunk (void *ptr)
+{
+  aiger_encoder *encoder = ptr;
+  aiger *public = encoder->public;
+  aiger_lit lhs, rhs0;
+  size_t res = 0;
+  unsigned i;
+
+  lhs = aiger_max_input_or_latch (public) + 2;
+  lhs += 2 * (aiger_lit) encoder->begin_and;
+  for (i = encoder->begin_and; i < encoder->end_and; i++, lhs += 2)
+    {
+      rhs0 = aiger_and_rhs0 (public, i);
+      res += aiger_delta_bytes (lhs - rhs0);
+      res += aiger_delta_bytes (rhs0 - aiger_and_rhs1 (public, i));
+    }
+
+  encoder->bytes = res;
+
+  return 0;
+}
+
+static void *
+aiger_encode_chunk (void *ptr)
+{
+  aiger_encoder *encoder = ptr;
+  aiger *public = encoder->public;
+  aiger_lit lhs, rhs0;
+  unsigned i;
+  char *p;
+
+  p = encoder->start;
+  lhs = aiger_max_input_or_latch (public) + 2;
+  lhs += 2 * (aiger_lit) encoder->begin_and;
+  for (i = encoder->begin_and; i < encoder->end_and; i++, lhs += 2)
+    {
+      rhs0 = aiger_and_rhs0 (public, i);
+      p = aiger_encode_delta (p, lhs - rhs0);
+      p = aiger_encode_delta (p, rhs0 - aiger_and_rhs1 (public, i));
+    }
+
+  assert (p == encoder->start + encoder->bytes);
+
+  return 0;
+}
+
+static int
+aiger_write_binary_parallel (aiger * public, aiger_writer * writer)
+{
+  IMPORT_private_FROM (public);
+  unsigned i, threads = writer->threads;
+  aiger_encoder *encoders;
+  size_t size, pos, bytes;
+  char *buffer;
+  int res;
+
+  NEWN (encoders, threads);
+
+  for (i = 0; i < threads; i++)
+    {
+      encoders[i].public = public;
+      encoders[i].begin_and = (public->num_ands / threads) * i;
+      encoders[i].end_and = (i + 1 == threads) ?
+	public->num_ands : (public->num_ands / threads) * (i + 1);
+    }
+
+  /* Both passes are pure, so if not all threads could be started, we
+   * simply do the work of all chunks in this thread.
+   */
+  if (!aiger_run_chunks (private, encoders, sizeof *encoders,
+			 threads, aiger_size_chunk))
+    for (i = 0; i < threads; i++)
+      aiger_size_chunk (encoders + i);
+
+  size = 0;
+  for (i = 0; i < threads; i++)
+    size += encoders[i].bytes;
+
+  NEWN (buffer, size);
+
+  encoders[0].start = buffer;
+  for (i = 1; i < threads; i++)
+    encoders[i].start = encoders[i - 1].start + encoders[i - 1].bytes;
+
+  if (!aiger_run_chunks (private, encoders, sizeof *encoders,
+			 threads, aiger_encode_chunk))
+    for (i = 0; i < threads; i++)
+      aiger_encode_chunk (encoders + i);
+
+  /* Pass the section in blocks, since call-backs such as 'gzwrite' of the
+   * compressed file writer can not handle arbitrary sizes.
+   */
+  res = aiger_writer_flush (writer);
+  for (pos = 0; res && pos < size; pos += bytes)
+    {
+      bytes = size - pos;
+      if (bytes > AIGER_BLOCK_SIZE)
+	bytes = AIGER_BLOCK_SIZE;
+      res = writer->put_block (buffer + pos, bytes, writer->state) == bytes;
+    }
+
+  DELETEN (buffer, size);
+  DELETEN (encoders, threads);
+
+  return res;
+}
+
+#endif
+
+static int
+aiger_write_binary (aiger * public, aiger_writer * writer)
+{
+  aiger_lit lhs, rhs0, rhs1;
+  unsigned i;
+
+  assert (!aiger_check (public));
+
+  aiger_reencode (public);
+
+  if (!aiger_write_header (public, "aig", 1, writer))
+    return 0;
+
+#ifdef AIGER_HAVE_PTHREAD
+  if (writer->threads > 1 && writer->put_block &&
+      public->num_ands / 1024 >= writer->threads)
+    return aiger_write_binary_parallel (public, writer);
+#endif
+
+  lhs = aiger_max_input_or_latch (public) + 2;
+
+  for (i = 0; i < public->num_ands; i++)
+    {
+      rhs0 = aiger_and_rhs0 (public, i);
+      rhs1 = aiger_and_rhs1 (public, i);
+
+      assert (lhs == aiger_and_lhs (public, i));
+      assert (lhs > rhs0);
+      assert (rhs0 >= rhs1);
+
+      if (!aiger_write_delta (writer, lhs - rhs0))
+	return 0;
+
+      if (!aiger_write_delta (writer, rhs0 - rhs1))
+	return 0;
+
+      lhs += 2;
+    }
+
+  return 1;
+}
+
+static unsigned
+strip_symbols_and_comments (aiger * public, int symbols, int comments)
+{
+  IMPORT_private_FROM (public);
+  unsigned res = 0;
+
+  assert (!aiger_error (public));
+
+  if (aiger_load_symbols (public))
+    return 0;
+
+  if (comments)
+    res += aiger_delete_comments (public);
+
+  if (!symbols)
+    return res;
+
+  res += aiger_delete_symbols_aux (private,
+				   public->inputs,
+				   private->size_inputs);
+  res += aiger_delete_symbols_aux (private,
+				   public->latches,
+				   private->size_latches);
+  res += aiger_delete_symbols_aux (private,
+				   public->outputs,
+				   private->size_outputs);
+  res += aiger_delete_symbols_aux (private,
+				   public->bad, 
+				   private->size_bad);
+  res += aiger_delete_symbols_aux (private,
+				   public->constraints,
+				   private->size_constraints);
+  res += aiger_delete_symbols_aux (private,
+				   public->justice,
+				   private->size_justice);
+  res += aiger_delete_symbols_aux (private,
+				   public->fairness,
+				   private->size_fairness);
+
+  aiger_arena_release (private, &private->name_arena);
+  aiger_invalidate (private);
+
+  if (comments)
+    {
+      DELETEN (private->section.start, private->section.size);
+      CLR (private->section);
+    }
+
+  return res;
+}
+
+unsigned
+aiger_strip_symbols_and_comments (aiger * public)
 {
   return strip_symbols_and_comments (public, 1, 1);
 }
@@ -1792,79 +2969,623 @@ aiger_strip_symbols (aiger * public)
   return strip_symbols_and_comments (public, 1, 0);
 }
 
-unsigned
-aiger_strip_comments (aiger * public)
+unsigned
+aiger_strip_comments (aiger * public)
+{
+  return strip_symbols_and_comments (public, 0, 1);
+}
+
+static int
+aiger_write_with_writer (aiger * public,
+			 aiger_mode mode, aiger_writer * writer)
+{
+  if (!(mode & aiger_stripped_mode) && aiger_load_symbols (public))
+    return 0;
+
+  if ((mode & aiger_ascii_mode))
+    {
+      if (!aiger_write_ascii (public, writer))
+	return 0;
+    }
+  else
+    {
+      if (!aiger_write_binary (public, writer))
+	return 0;
+    }
+
+  if (!(mode & aiger_stripped_mode))
+    {
+      if (aiger_have_at_least_one_symbol (public))
+	{
+	  if (!aiger_write_symbols (public, writer))
+	    return 0;
+	}
+
+      if (public->comments[0])
+	{
+	  if (aiger_put_s (writer, "c\n") == EOF)
+	    return 0;
+
+	  if (!aiger_write_comments (public, writer))
+	    return 0;
+	}
+    }
+
+  return 1;
+}
+
+int
+aiger_write_generic (aiger * public,
+		     aiger_mode mode, void *state, aiger_put put)
+{
+  aiger_writer writer;
+
+  assert (!aiger_error (public));
+
+  CLR (writer);
+  writer.state = state;
+  writer.put = put;
+
+  return aiger_write_with_writer (public, mode, &writer);
+}
+
+int
+aiger_write_blocks (aiger * public,
+		    aiger_mode mode, void *state, aiger_put_block put_block)
+{
+  IMPORT_private_FROM (public);
+  aiger_writer writer;
+  int res;
+
+  assert (!aiger_error (public));
+
+  aiger_init_block_writer (private, &writer, state, put_block);
+  res = aiger_write_with_writer (public, mode, &writer);
+
+  return aiger_release_block_writer (private, &writer, res);
+}
+
+int
+aiger_write_to_file (aiger * public, aiger_mode mode, FILE * file)
+{
+  assert (!aiger_error (public));
+  return aiger_write_blocks (public,
+			     mode, file, (aiger_put_block) aiger_file_put_block);
+}
+
+int
+aiger_write_to_string (aiger * public, aiger_mode mode, char *str, size_t len)
+{
+  aiger_buffer buffer;
+  int res;
+
+  assert (!aiger_error (public));
+
+  buffer.start = str;
+  buffer.cursor = str;
+  buffer.end = str + len;
+  res = aiger_write_blocks (public,
+			    mode, &buffer,
+			    (aiger_put_block) aiger_string_put_block);
+
+  if (!res)
+    return 0;
+
+  if (!aiger_string_put_block ("", 1, &buffer))
+    return 0;
+
+  return 1;
+}
+
+/* Number of digits of 'u' as written by 'aiger_put_u'.
+ */
+static size_t
+aiger_digits (aiger_lit u)
+{
+  size_t res = 1;
+  while (u >= 10)
+    {
+      u /= 10;
+      res++;
+    }
+  return res;
+}
+
+/* Size of lines with one literal each.
+ */
+static size_t
+aiger_lits_size (aiger_symbol * symbols, unsigned size)
+{
+  size_t res = 0;
+  unsigned i;
+
+  for (i = 0; i < size; i++)
+    res += aiger_digits (symbols[i].lit) + 1;
+
+  return res;
+}
+
+/* Same as 'aiger_write_header' but only counts the bytes.
+ */
+static size_t
+aiger_header_size (aiger * public, int compact_inputs_and_latches)
+{
+  aiger_symbol *symbol;
+  unsigned i, j;
+  size_t res;
+
+  res = 3 + 1 + aiger_digits (public->maxvar);
+  res += 1 + aiger_digits (public->num_inputs);
+  res += 1 + aiger_digits (public->num_latches);
+  res += 1 + aiger_digits (public->num_outputs);
+  res += 1 + aiger_digits (public->num_ands);
+  if (public->num_bad || public->num_constraints ||
+      public->num_justice || public->num_fairness)
+    res += 1 + aiger_digits (public->num_bad);
+  if (public->num_constraints || public->num_justice || public->num_fairness)
+    res += 1 + aiger_digits (public->num_constraints);
+  if (public->num_justice || public->num_fairness)
+    res += 1 + aiger_digits (public->num_justice);
+  if (public->num_fairness)
+    res += 1 + aiger_digits (public->num_fairness);
+  res++;
+
+  if (!compact_inputs_and_latches)
+    res += aiger_lits_size (public->inputs, public->num_inputs);
+
+  for (i = 0; i < public->num_latches; i++)
+    {
+      symbol = public->latches + i;
+      if (!compact_inputs_and_latches)
+	res += aiger_digits (symbol->lit) + 1;
+      res += aiger_digits (symbol->next) + 1;
+      if (symbol->reset)
+	res += 1 + aiger_digits (symbol->reset);
+    }
+
+  res += aiger_lits_size (public->outputs, public->num_outputs);
+  res += aiger_lits_size (public->bad, public->num_bad);
+  res += aiger_lits_size (public->constraints, public->num_constraints);
+
+  for (i = 0; i < public->num_justice; i++)
+    {
+      symbol = public->justice + i;
+      res += aiger_digits (symbol->size) + 1;
+      for (j = 0; j < symbol->size; j++)
+	res += aiger_digits (symbol->lits[j]) + 1;
+    }
+
+  res += aiger_lits_size (public->fairness, public->num_fairness);
+
+  return res;
+}
+
+/* Same as 'aiger_write_symbols_aux' but only counts the bytes.
+ */
+static size_t
+aiger_symbols_size (aiger_symbol * symbols, unsigned size)
+{
+  size_t res = 0;
+  unsigned i;
+
+  for (i = 0; i < size; i++)
+    if (symbols[i].name)
+      res += 1 + aiger_digits (i) + 1 + strlen (symbols[i].name) + 1;
+
+  return res;
+}
+
+/* The size is computed from the decimal lengths of all numbers, the sizes
+ * of the binary deltas and the lengths of symbols and comments, following
+ * exactly what 'aiger_write_with_writer' produces, but without encoding.
+ */
+size_t
+aiger_binary_size (aiger * public, aiger_mode mode)
+{
+  aiger_lit lhs, rhs0, rhs1;
+  size_t res;
+  char **p;
+  unsigned i;
+
+  assert (!aiger_error (public));
+  assert (!aiger_check (public));
+
+  if (!(mode & aiger_stripped_mode) && aiger_load_symbols (public))
+    return 0;
+
+  if (mode & aiger_ascii_mode)
+    {
+      res = aiger_header_size (public, 0);
+      for (i = 0; i < public->num_ands; i++)
+	{
+	  res += aiger_digits (aiger_and_lhs (public, i)) + 1;
+	  res += aiger_digits (aiger_and_rhs0 (public, i)) + 1;
+	  res += aiger_digits (aiger_and_rhs1 (public, i)) + 1;
+	}
+    }
+  else
+    {
+      aiger_reencode (public);
+      res = aiger_header_size (public, 1);
+      lhs = aiger_max_input_or_latch (public) + 2;
+      for (i = 0; i < public->num_ands; i++, lhs += 2)
+	{
+	  rhs0 = aiger_and_rhs0 (public, i);
+	  rhs1 = aiger_and_rhs1 (public, i);
+	  res += aiger_delta_bytes (lhs - rhs0);
+	  res += aiger_delta_bytes (rhs0 - rhs1);
+	}
+    }
+
+  if (!(mode & aiger_stripped_mode))
+    {
+      res += aiger_symbols_size (public->inputs, public->num_inputs);
+      res += aiger_symbols_size (public->latches, public->num_latches);
+      res += aiger_symbols_size (public->outputs, public->num_outputs);
+      res += aiger_symbols_size (public->bad, public->num_bad);
+      res += aiger_symbols_size (public->constraints,
+				 public->num_constraints);
+      res += aiger_symbols_size (public->justice, public->num_justice);
+      res += aiger_symbols_size (public->fairness, public->num_fairness);
+
+      if (public->comments[0])
+	{
+	  res += 2;
+	  for (p = public->comments; *p; p++)
+	    res += strlen (*p) + 1;
+	}
+    }
+
+  return res;
+}
+
+char *
+aiger_write_to_new_buffer (aiger * public, aiger_mode mode, size_t * size_ptr)
+{
+  IMPORT_private_FROM (public);
+  size_t size;
+  char *res;
+
+  assert (!aiger_error (public));
+
+  size = aiger_binary_size (public, mode);
+  if (!size)
+    return 0;
+
+  res = private->malloc_callback (private->memory_mgr, size + 1);
+  if (!aiger_write_to_string (public, mode, res, size + 1))
+    {
+      private->free_callback (private->memory_mgr, res, size + 1);
+      return 0;
+    }
+
+  assert (!res[size]);
+  *size_ptr = size;
+
+  return res;
+}
+
+/*------------------------------------------------------------------------*/
+/* Streaming binary writer.  Everything is written in file order right away
+ * except for justice properties, since all their sizes come before their
+ * literals.  These are collected until the justice section is left.
+ */
+enum aiger_stream_section
+{
+  AIGER_STREAM_LATCHES = 0,
+  AIGER_STREAM_OUTPUTS,
+  AIGER_STREAM_BAD,
+  AIGER_STREAM_CONSTRAINTS,
+  AIGER_STREAM_JUSTICE,
+  AIGER_STREAM_FAIRNESS,
+  AIGER_STREAM_ANDS,
+  AIGER_STREAM_SYMBOLS,
+  AIGER_STREAM_COMMENTS,
+};
+
+struct aiger_stream_writer
+{
+  aiger_private *private;
+  aiger_writer writer;
+  aiger_header header;
+
+  enum aiger_stream_section section;
+  unsigned count;		/* of entries in current section */
+  aiger_lit lhs;		/* of the last AND */
+
+  unsigned *sizes;		/* justice sizes [0..header.justice[ */
+  aiger_lit *lits;
+  unsigned num_lits, size_lits;
+
+  int ok;			/* no write error or wrong count so far */
+};
+
+static unsigned
+aiger_stream_expected (aiger_stream_writer * stream)
+{
+  switch (stream->section)
+    {
+    case AIGER_STREAM_LATCHES:
+      return stream->header.latches;
+    case AIGER_STREAM_OUTPUTS:
+      return stream->header.outputs;
+    case AIGER_STREAM_BAD:
+      return stream->header.bad;
+    case AIGER_STREAM_CONSTRAINTS:
+      return stream->header.constraints;
+    case AIGER_STREAM_JUSTICE:
+      return stream->header.justice;
+    case AIGER_STREAM_FAIRNESS:
+      return stream->header.fairness;
+    case AIGER_STREAM_ANDS:
+      return stream->header.ands;
+    default:
+      return 0;			/* unbounded */
+    }
+}
+
+/* Count a new entry of the current section.  Too many entries do not match
+ * the header and make the writer fail.
+ */
+static int
+aiger_stream_count (aiger_stream_writer * stream)
+{
+  if (stream->count >= aiger_stream_expected (stream))
+    stream->ok = 0;
+  else
+    stream->count++;
+  return stream->ok;
+}
+
+static int
+aiger_stream_flush_justice (aiger_stream_writer * stream)
+{
+  aiger_writer *writer = &stream->writer;
+  unsigned i;
+
+  for (i = 0; i < stream->header.justice; i++)
+    if (aiger_put_u (writer, stream->sizes[i]) == EOF ||
+	aiger_writer_put (writer, '\n') == EOF)
+      return 0;
+
+  for (i = 0; i < stream->num_lits; i++)
+    if (aiger_put_u (writer, stream->lits[i]) == EOF ||
+	aiger_writer_put (writer, '\n') == EOF)
+      return 0;
+
+  return 1;
+}
+
+/* Move on to 'section', which requires that all previous sections are
+ * complete.  Returns zero after write errors or if a previous section has
+ * fewer entries than given in the header.
+ */
+static int
+aiger_stream_enter (aiger_stream_writer * stream,
+		    enum aiger_stream_section section)
+{
+  assert (stream->section <= section);
+
+  while (stream->section < section)
+    {
+      if (stream->section < AIGER_STREAM_SYMBOLS &&
+	  stream->count != aiger_stream_expected (stream))
+	stream->ok = 0;
+
+      if (stream->ok && stream->section == AIGER_STREAM_JUSTICE)
+	stream->ok = aiger_stream_flush_justice (stream);
+
+      stream->section++;
+      stream->count = 0;
+    }
+
+  return stream->ok;
+}
+
+static int
+aiger_stream_lit (aiger_stream_writer * stream,
+		  enum aiger_stream_section section, aiger_lit lit)
+{
+  if (!aiger_stream_enter (stream, section))
+    return 0;
+
+  if (!aiger_stream_count (stream))
+    return 0;
+  assert (aiger_lit2var (lit) <= stream->header.maxvar);
+
+  stream->ok = aiger_put_u (&stream->writer, lit) != EOF &&
+    aiger_writer_put (&stream->writer, '\n') != EOF;
+
+  return stream->ok;
+}
+
+aiger_stream_writer *
+aiger_new_stream_writer (aiger * public, const aiger_header * header,
+			 void *state, aiger_put_block put_block)
+{
+  IMPORT_private_FROM (public);
+  aiger_stream_writer *res;
+
+  assert (!aiger_error (public));
+  assert (header->maxvar ==
+	  header->inputs + header->latches + header->ands);
+
+  NEWN (res, 1);
+  res->private = private;
+  res->header = *header;
+  res->header.mode = aiger_binary_mode;
+  res->lhs = 2 * ((aiger_lit) header->inputs + header->latches);
+  if (header->justice)
+    NEWN (res->sizes, header->justice);
+
+  aiger_init_block_writer (private, &res->writer, state, put_block);
+  res->ok = aiger_write_header_line (&res->writer, "aig", &res->header);
+
+  return res;
+}
+
+aiger_stream_writer *
+aiger_new_stream_writer_to_file (aiger * public,
+				 const aiger_header * header, FILE * file)
+{
+  return aiger_new_stream_writer (public, header, file,
+				  (aiger_put_block) aiger_file_put_block);
+}
+
+int
+aiger_stream_latch (aiger_stream_writer * stream,
+		    aiger_lit next, aiger_lit reset)
+{
+  aiger_writer *writer = &stream->writer;
+
+  if (!aiger_stream_enter (stream, AIGER_STREAM_LATCHES))
+    return 0;
+
+  if (!aiger_stream_count (stream))
+    return 0;
+  assert (aiger_lit2var (next) <= stream->header.maxvar);
+
+  stream->ok = aiger_put_u (writer, next) != EOF;
+  if (stream->ok && reset)
+    stream->ok = aiger_writer_put (writer, ' ') != EOF &&
+      aiger_put_u (writer, reset) != EOF;
+  if (stream->ok)
+    stream->ok = aiger_writer_put (writer, '\n') != EOF;
+
+  return stream->ok;
+}
+
+int
+aiger_stream_output (aiger_stream_writer * stream, aiger_lit lit)
+{
+  return aiger_stream_lit (stream, AIGER_STREAM_OUTPUTS, lit);
+}
+
+int
+aiger_stream_bad (aiger_stream_writer * stream, aiger_lit lit)
+{
+  return aiger_stream_lit (stream, AIGER_STREAM_BAD, lit);
+}
+
+int
+aiger_stream_constraint (aiger_stream_writer * stream, aiger_lit lit)
 {
-  return strip_symbols_and_comments (public, 0, 1);
+  return aiger_stream_lit (stream, AIGER_STREAM_CONSTRAINTS, lit);
 }
 
 int
-aiger_write_generic (aiger * public,
-		     aiger_mode mode, void *state, aiger_put put)
+aiger_stream_justice (aiger_stream_writer * stream,
+		      unsigned size, const aiger_lit *lits)
 {
-  assert (!aiger_error (public));
+  aiger_private *private = stream->private;
+  unsigned i;
 
-  if ((mode & aiger_ascii_mode))
-    {
-      if (!aiger_write_ascii (public, state, put))
-	return 0;
-    }
-  else
+  if (!aiger_stream_enter (stream, AIGER_STREAM_JUSTICE))
+    return 0;
+
+  if (!aiger_stream_count (stream))
+    return 0;
+  stream->sizes[stream->count - 1] = size;
+
+  for (i = 0; i < size; i++)
     {
-      if (!aiger_write_binary (public, state, put))
-	return 0;
+      assert (aiger_lit2var (lits[i]) <= stream->header.maxvar);
+      PUSH (stream->lits, stream->num_lits, stream->size_lits, lits[i]);
     }
 
-  if (!(mode & aiger_stripped_mode))
-    {
-      if (aiger_have_at_least_one_symbol (public))
-	{
-	  if (!aiger_write_symbols (public, state, put))
-	    return 0;
-	}
+  return 1;
+}
 
-      if (public->comments[0])
-	{
-	  if (aiger_put_s (state, put, "c\n") == EOF)
-	    return 0;
+int
+aiger_stream_fairness (aiger_stream_writer * stream, aiger_lit lit)
+{
+  return aiger_stream_lit (stream, AIGER_STREAM_FAIRNESS, lit);
+}
 
-	  if (!aiger_write_comments (public, state, put))
-	    return 0;
-	}
+aiger_lit
+aiger_stream_and (aiger_stream_writer * stream,
+		  aiger_lit rhs0, aiger_lit rhs1)
+{
+  aiger_lit lhs, tmp;
+
+  if (!aiger_stream_enter (stream, AIGER_STREAM_ANDS))
+    return 0;
+
+  if (!aiger_stream_count (stream))
+    return 0;
+
+  lhs = stream->lhs += 2;
+
+  if (rhs0 < rhs1)
+    {
+      tmp = rhs0;
+      rhs0 = rhs1;
+      rhs1 = tmp;
     }
 
-  return 1;
+  assert (lhs > rhs0);
+
+  stream->ok = aiger_write_delta (&stream->writer, lhs - rhs0) &&
+    aiger_write_delta (&stream->writer, rhs0 - rhs1);
+
+  return stream->ok ? lhs : 0;
 }
 
 int
-aiger_write_to_file (aiger * public, aiger_mode mode, FILE * file)
+aiger_stream_symbol (aiger_stream_writer * stream,
+		     char type, unsigned pos, const char *name)
 {
-  assert (!aiger_error (public));
-  return aiger_write_generic (public,
-			      mode, file, (aiger_put) aiger_default_put);
+  aiger_writer *writer = &stream->writer;
+
+  if (!aiger_stream_enter (stream, AIGER_STREAM_SYMBOLS))
+    return 0;
+
+  assert (strchr ("ilobcjf", type));
+
+  stream->ok = aiger_writer_put (writer, type) != EOF &&
+    aiger_put_u (writer, pos) != EOF &&
+    aiger_writer_put (writer, ' ') != EOF &&
+    aiger_put_s (writer, name) != EOF &&
+    aiger_writer_put (writer, '\n') != EOF;
+
+  return stream->ok;
 }
 
 int
-aiger_write_to_string (aiger * public, aiger_mode mode, char *str, size_t len)
+aiger_stream_comment (aiger_stream_writer * stream, const char *comment)
 {
-  aiger_buffer buffer;
-  int res;
+  aiger_writer *writer = &stream->writer;
 
-  assert (!aiger_error (public));
+  if (!aiger_stream_enter (stream, AIGER_STREAM_COMMENTS))
+    return 0;
 
-  buffer.start = str;
-  buffer.cursor = str;
-  buffer.end = str + len;
-  res = aiger_write_generic (public,
-			     mode, &buffer, (aiger_put) aiger_string_put);
+  if (!stream->count++ && aiger_put_s (writer, "c\n") == EOF)
+    return stream->ok = 0;
 
-  if (!res)
-    return 0;
+  stream->ok = aiger_put_s (writer, comment) != EOF &&
+    aiger_writer_put (writer, '\n') != EOF;
 
-  if (aiger_string_put (0, &buffer) == EOF)
-    return 0;
+  return stream->ok;
+}
 
-  return 1;
+int
+aiger_delete_stream_writer (aiger_stream_writer * stream)
+{
+  aiger_private *private = stream->private;
+  int res;
+
+  if (stream->section < AIGER_STREAM_SYMBOLS)
+    res = aiger_stream_enter (stream, AIGER_STREAM_SYMBOLS);
+  else
+    res = stream->ok;
+  res = aiger_release_block_writer (private, &stream->writer, res);
+
+  if (stream->sizes)
+    DELETEN (stream->sizes, stream->header.justice);
+  DELETEN (stream->lits, stream->size_lits);
+  DELETEN (stream, 1);
+
+  return res;
 }
 
 static int
@@ -1876,19 +3597,418 @@ aiger_has_suffix (const char *str, const char *suffix)
   return !strcmp (str + strlen (str) - strlen (suffix), suffix);
 }
 
+#ifdef AIGER_HAVE_CODEC
+
+/*------------------------------------------------------------------------*/
+/* In-process compression and decompression of '.gz', '.xz' and '.zst'
+ * files through 'zlib', 'liblzma' and 'libzstd' respectively, as far as
+ * these libraries were found by 'configure.sh'.  Otherwise we fall back to
+ * piping through external 'gzip', 'xz' and 'zstd' processes.
+ */
+typedef struct aiger_zfile aiger_zfile;
+
+struct aiger_zfile
+{
+  char codec;			/* 'g' = gzip, 'x' = xz, 'z' = zstd */
+  int writing;
+  int eof;
+  int failed;
+  FILE *file;
+#ifdef AIGER_HAVE_ZLIB
+  gzFile gz;
+#endif
+#ifdef AIGER_HAVE_LZMA
+  lzma_stream xz;
+#endif
+#ifdef AIGER_HAVE_ZSTD
+  ZSTD_DStream *zstd_decoder;
+  ZSTD_CStream *zstd_encoder;
+  ZSTD_inBuffer zstd_in;
+  int zstd_done;		/* last frame completely flushed */
+#endif
+  unsigned char *buffer;	/* [0..AIGER_BLOCK_SIZE[ compressed data */
+};
+
+static char
+aiger_zfile_codec (const char *file_name)
+{
+#ifdef AIGER_HAVE_ZLIB
+  if (aiger_has_suffix (file_name, ".gz"))
+    return 'g';
+#endif
+#ifdef AIGER_HAVE_LZMA
+  if (aiger_has_suffix (file_name, ".xz"))
+    return 'x';
+#endif
+#ifdef AIGER_HAVE_ZSTD
+  if (aiger_has_suffix (file_name, ".zst"))
+    return 'z';
+#endif
+  return 0;
+}
+
+/* Returns zero if the file could not be opened or the codec could not be
+ * initialized.  In this case nothing has to be released.
+ */
+static int
+aiger_zfile_open (aiger_private * private, aiger_zfile * zfile,
+		  const char *file_name, int writing)
+{
+  CLR (*zfile);
+  zfile->codec = aiger_zfile_codec (file_name);
+  zfile->writing = writing;
+  assert (zfile->codec);
+#ifdef AIGER_HAVE_ZLIB
+  if (zfile->codec == 'g')
+    {
+      zfile->gz = gzopen (file_name, writing ? "wb" : "rb");
+      if (!zfile->gz)
+	return 0;
+      gzbuffer (zfile->gz, AIGER_BLOCK_SIZE);
+      return 1;
+    }
+#endif
+  zfile->file = fopen (file_name, writing ? "wb" : "rb");
+  if (!zfile->file)
+    return 0;
+#ifdef AIGER_HAVE_LZMA
+  if (zfile->codec == 'x')
+    {
+      lzma_stream init = LZMA_STREAM_INIT;
+      lzma_ret ret;
+      zfile->xz = init;
+      if (writing)
+	ret = lzma_easy_encoder (&zfile->xz, 6, LZMA_CHECK_CRC64);
+      else
+	ret = lzma_stream_decoder (&zfile->xz, UINT64_MAX,
+				   LZMA_CONCATENATED);
+      if (ret != LZMA_OK)
+	{
+	  fclose (zfile->file);
+	  return 0;
+	}
+    }
+#endif
+#ifdef AIGER_HAVE_ZSTD
+  if (zfile->codec == 'z')
+    {
+      if (writing)
+	zfile->zstd_encoder = ZSTD_createCStream ();
+      else
+	zfile->zstd_decoder = ZSTD_createDStream ();
+      if (!zfile->zstd_encoder && !zfile->zstd_decoder)
+	{
+	  fclose (zfile->file);
+	  return 0;
+	}
+    }
+#endif
+  NEWN (zfile->buffer, AIGER_BLOCK_SIZE);
+  return 1;
+}
+
+/* Read more compressed data into the buffer unless we reached the end of
+ * the file.  Returns the number of bytes available.
+ */
+static size_t
+aiger_zfile_fill (aiger_zfile * zfile)
+{
+  size_t res;
+  assert (!zfile->writing);
+  if (zfile->eof)
+    return 0;
+  res = fread (zfile->buffer, 1, AIGER_BLOCK_SIZE, zfile->file);
+  if (res < AIGER_BLOCK_SIZE)
+    zfile->eof = 1;
+  return res;
+}
+
+static size_t
+aiger_zfile_get_block (char *buffer, size_t size, aiger_zfile * zfile)
+{
+  assert (!zfile->writing);
+  if (zfile->failed)
+    return 0;
+#ifdef AIGER_HAVE_ZLIB
+  if (zfile->codec == 'g')
+    {
+      /* 'gzread' takes 'unsigned' and returns 'int'.
+       */
+      size_t res = 0, chunk;
+      int bytes;
+      do
+	{
+	  chunk = size - res;
+	  if (chunk > INT_MAX)
+	    chunk = INT_MAX;
+	  bytes = gzread (zfile->gz, buffer + res, chunk);
+	  if (bytes < 0)
+	    {
+	      zfile->failed = 1;
+	      return 0;
+	    }
+	  res += bytes;
+	}
+      while (res < size && (size_t) bytes == chunk);
+      return res;
+    }
+#endif
+#ifdef AIGER_HAVE_LZMA
+  if (zfile->codec == 'x')
+    {
+      lzma_stream *xz = &zfile->xz;
+      lzma_ret ret;
+      xz->next_out = (uint8_t *) buffer;
+      xz->avail_out = size;
+      while (xz->avail_out == size && !zfile->failed)
+	{
+	  if (!xz->avail_in)
+	    {
+	      xz->next_in = zfile->buffer;
+	      xz->avail_in = aiger_zfile_fill (zfile);
+	    }
+	  ret = lzma_code (xz, zfile->eof ? LZMA_FINISH : LZMA_RUN);
+	  if (ret == LZMA_STREAM_END)
+	    break;
+	  if (ret != LZMA_OK)
+	    zfile->failed = 1;
+	}
+      return size - xz->avail_out;
+    }
+#endif
+#ifdef AIGER_HAVE_ZSTD
+  if (zfile->codec == 'z')
+    {
+      ZSTD_outBuffer out;
+      size_t ret;
+      out.dst = buffer;
+      out.size = size;
+      out.pos = 0;
+      while (!out.pos && !zfile->failed)
+	{
+	  if (zfile->zstd_in.pos == zfile->zstd_in.size)
+	    {
+	      if (zfile->eof && zfile->zstd_done)
+		break;
+	      if (!zfile->eof)
+		{
+		  zfile->zstd_in.src = zfile->buffer;
+		  zfile->zstd_in.size = aiger_zfile_fill (zfile);
+		  zfile->zstd_in.pos = 0;
+		}
+	    }
+	  ret = ZSTD_decompressStream (zfile->zstd_decoder,
+				       &out, &zfile->zstd_in);
+	  if (ZSTD_isError (ret))
+	    {
+	      zfile->failed = 1;
+	      break;
+	    }
+	  zfile->zstd_done = !ret;
+	  /* Without further input the decoder might still flush buffered
+	   * output, which it does until it leaves space in 'out'.  If it
+	   * then still expects more input the file is truncated.
+	   */
+	  if (zfile->zstd_in.pos == zfile->zstd_in.size && zfile->eof
+	      && (!ret || out.pos < out.size))
+	    {
+	      if (ret)
+		zfile->failed = 1;
+	      break;
+	    }
+	}
+      return out.pos;
+    }
+#endif
+  assert (!"unexpected codec");
+  return 0;
+}
+
+static size_t
+aiger_zfile_put_block (const char *buffer, size_t size, aiger_zfile * zfile)
+{
+  assert (zfile->writing);
+  if (zfile->failed)
+    return 0;
+#ifdef AIGER_HAVE_ZLIB
+  if (zfile->codec == 'g')
+    {
+      size_t res = 0, chunk;
+      while (res < size)
+	{
+	  chunk = size - res;
+	  if (chunk > INT_MAX)
+	    chunk = INT_MAX;
+	  if ((size_t) gzwrite (zfile->gz, buffer + res, chunk) != chunk)
+	    {
+	      zfile->failed = 1;
+	      break;
+	    }
+	  res += chunk;
+	}
+      return res;
+    }
+#endif
+#ifdef AIGER_HAVE_LZMA
+  if (zfile->codec == 'x')
+    {
+      lzma_stream *xz = &zfile->xz;
+      xz->next_in = (const uint8_t *) buffer;
+      xz->avail_in = size;
+      while (xz->avail_in && !zfile->failed)
+	{
+	  xz->next_out = zfile->buffer;
+	  xz->avail_out = AIGER_BLOCK_SIZE;
+	  if (lzma_code (xz, LZMA_RUN) != LZMA_OK)
+	    zfile->failed = 1;
+	  else
+	    {
+	      size_t bytes = AIGER_BLOCK_SIZE - xz->avail_out;
+	      if (fwrite (zfile->buffer, 1, bytes, zfile->file) != bytes)
+		zfile->failed = 1;
+	    }
+	}
+      return zfile->failed ? 0 : size;
+    }
+#endif
+#ifdef AIGER_HAVE_ZSTD
+  if (zfile->codec == 'z')
+    {
+      ZSTD_inBuffer in;
+      ZSTD_outBuffer out;
+      in.src = buffer;
+      in.size = size;
+      in.pos = 0;
+      while (in.pos < in.size && !zfile->failed)
+	{
+	  out.dst = zfile->buffer;
+	  out.size = AIGER_BLOCK_SIZE;
+	  out.pos = 0;
+	  if (ZSTD_isError (ZSTD_compressStream2 (zfile->zstd_encoder,
+						  &out, &in, ZSTD_e_continue)))
+	    zfile->failed = 1;
+	  else if (fwrite (zfile->buffer, 1, out.pos, zfile->file) != out.pos)
+	    zfile->failed = 1;
+	}
+      return zfile->failed ? 0 : size;
+    }
+#endif
+  assert (!"unexpected codec");
+  return 0;
+}
+
+/* Finish the compressed stream if writing and release all resources.
+ * Returns zero if finishing or closing the file failed.
+ */
+static int
+aiger_zfile_close (aiger_private * private, aiger_zfile * zfile)
+{
+  int res = !zfile->failed;
+#ifdef AIGER_HAVE_ZLIB
+  if (zfile->codec == 'g')
+    return (gzclose (zfile->gz) == Z_OK) && res;
+#endif
+#ifdef AIGER_HAVE_LZMA
+  if (zfile->codec == 'x')
+    {
+      lzma_stream *xz = &zfile->xz;
+      lzma_ret ret = LZMA_OK;
+      while (zfile->writing && res && ret == LZMA_OK)
+	{
+	  size_t bytes;
+	  xz->next_out = zfile->buffer;
+	  xz->avail_out = AIGER_BLOCK_SIZE;
+	  ret = lzma_code (xz, LZMA_FINISH);
+	  if (ret != LZMA_OK && ret != LZMA_STREAM_END)
+	    res = 0;
+	  bytes = AIGER_BLOCK_SIZE - xz->avail_out;
+	  if (fwrite (zfile->buffer, 1, bytes, zfile->file) != bytes)
+	    res = 0;
+	}
+      lzma_end (xz);
+    }
+#endif
+#ifdef AIGER_HAVE_ZSTD
+  if (zfile->codec == 'z')
+    {
+      if (zfile->writing)
+	{
+	  ZSTD_inBuffer in;
+	  ZSTD_outBuffer out;
+	  size_t remaining = 1;
+	  in.src = 0;
+	  in.size = in.pos = 0;
+	  while (res && remaining)
+	    {
+	      out.dst = zfile->buffer;
+	      out.size = AIGER_BLOCK_SIZE;
+	      out.pos = 0;
+	      remaining = ZSTD_compressStream2 (zfile->zstd_encoder,
+						&out, &in, ZSTD_e_end);
+	      if (ZSTD_isError (remaining))
+		res = 0;
+	      else if (fwrite (zfile->buffer, 1, out.pos, zfile->file)
+		       != out.pos)
+		res = 0;
+	    }
+	  ZSTD_freeCStream (zfile->zstd_encoder);
+	}
+      else
+	ZSTD_freeDStream (zfile->zstd_decoder);
+    }
+#endif
+  DELETEN (zfile->buffer, AIGER_BLOCK_SIZE);
+  if (fclose (zfile->file))
+    res = 0;
+  return res;
+}
+
+#endif
+
 int
 aiger_open_and_write_to_file (aiger * public, const char *file_name)
 {
   IMPORT_private_FROM (public);
   int res, pclose_file;
-  char *cmd, size_cmd;
+  size_t size_cmd;
   aiger_mode mode;
   FILE *file;
+  char *cmd;
+#ifdef AIGER_HAVE_CODEC
+  aiger_zfile zfile;
+#endif
 
   assert (!aiger_error (public));
 
   assert (file_name);
 
+  if (aiger_has_suffix (file_name, ".aag") ||
+      aiger_has_suffix (file_name, ".aag.gz") ||
+      aiger_has_suffix (file_name, ".aag.xz") ||
+      aiger_has_suffix (file_name, ".aag.zst"))
+    mode = aiger_ascii_mode;
+  else
+    mode = aiger_binary_mode;
+
+#ifdef AIGER_HAVE_CODEC
+  if (aiger_zfile_codec (file_name))
+    {
+      if (!aiger_zfile_open (private, &zfile, file_name, 1))
+	return 0;
+
+      res = aiger_write_blocks (public, mode, &zfile,
+				(aiger_put_block) aiger_zfile_put_block);
+
+      if (!aiger_zfile_close (private, &zfile))
+	res = 0;
+
+      if (!res)
+	unlink (file_name);
+
+      return res;
+    }
+#endif
+
   if (aiger_has_suffix (file_name, ".gz"))
     {
       size_cmd = strlen (file_name) + strlen (GZIP);
@@ -1907,6 +4027,15 @@ aiger_open_and_write_to_file (aiger * public, const char *file_name)
       DELETEN (cmd, size_cmd);
       pclose_file = 1;
     }
+  else if (aiger_has_suffix (file_name, ".zst"))
+    {
+      size_cmd = strlen (file_name) + strlen (ZSTDZIP);
+      NEWN (cmd, size_cmd);
+      sprintf (cmd, ZSTDZIP, file_name);
+      file = popen (cmd, "w");
+      DELETEN (cmd, size_cmd);
+      pclose_file = 1;
+    }
   else
     {
       file = fopen (file_name, "w");
@@ -1916,13 +4045,6 @@ aiger_open_and_write_to_file (aiger * public, const char *file_name)
   if (!file)
     return 0;
 
-  if (aiger_has_suffix (file_name, ".aag") ||
-      aiger_has_suffix (file_name, ".aag.gz") ||
-      aiger_has_suffix (file_name, ".aag.xz"))
-    mode = aiger_ascii_mode;
-  else
-    mode = aiger_binary_mode;
-
   res = aiger_write_to_file (public, mode, file);
 
   if (pclose_file)
@@ -1936,12 +4058,38 @@ aiger_open_and_write_to_file (aiger * public, const char *file_name)
   return res;
 }
 
+static int
+aiger_refill (aiger_reader * reader)
+{
+  size_t bytes;
+
+  assert (reader->get_block);
+  assert (reader->block);
+
+  bytes = reader->get_block (reader->block, AIGER_BLOCK_SIZE, reader->state);
+  if (!bytes)
+    return EOF;
+
+  assert (bytes <= AIGER_BLOCK_SIZE);
+  reader->cursor = (unsigned char *) reader->block;
+  reader->end = reader->cursor + bytes;
+
+  return *reader->cursor++;
+}
+
 static int
 aiger_next_ch (aiger_reader * reader)
 {
   int res;
 
-  res = reader->get (reader->state);
+  if (reader->cursor < reader->end)
+    res = *reader->cursor++;
+  else if (reader->get_block)
+    res = aiger_refill (reader);
+  else if (reader->get)
+    res = reader->get (reader->state);
+  else
+    res = EOF;
 
   if (isspace (reader->ch) && !isspace (res))
     reader->lineno_at_last_token_start = reader->lineno;
@@ -1966,10 +4114,10 @@ aiger_next_ch (aiger_reader * reader)
 /* Read a number assuming that the current character has already been
  * checked to be a digit, e.g. the start of the number to be read.
  */
-static unsigned
+static aiger_lit
 aiger_read_number (aiger_reader * reader)
 {
-  unsigned res;
+  aiger_lit res;
 
   assert (isdigit (reader->ch));
   res = reader->ch - '0';
@@ -1990,11 +4138,11 @@ static const char *
 aiger_read_literal (aiger_private * private,
 		    aiger_reader * reader,
 		    const char * context,
-		    unsigned *res_ptr, 
+		    aiger_lit *res_ptr, 
 		    char expected_followed_by,
 		    char * followed_by_ptr)
 {
-  unsigned res;
+  aiger_lit res;
 
   assert (expected_followed_by == ' ' || 
           expected_followed_by == '\n' ||
@@ -2032,26 +4180,53 @@ aiger_read_literal (aiger_private * private,
   if (followed_by_ptr)
     *followed_by_ptr = reader->ch;
 
-  aiger_next_ch (reader);	/* skip white space */
+  aiger_next_ch (reader);	/* skip white space */
+
+  *res_ptr = res;
+
+  return 0;
+}
+
+/* Same for the number of inputs, latches etc. and the size of justice
+ * properties, which are 'unsigned' even in wide mode.
+ */
+static const char *
+aiger_read_count (aiger_private * private,
+		  aiger_reader * reader,
+		  const char * context,
+		  unsigned *res_ptr,
+		  char expected_followed_by,
+		  char * followed_by_ptr)
+{
+  const char *error;
+  aiger_lit res;
+
+  error = aiger_read_literal (private, reader, context, &res,
+			      expected_followed_by, followed_by_ptr);
+  if (error)
+    return error;
 
   *res_ptr = res;
+  if (*res_ptr != res)
+    return aiger_error_us (private, "line %u: %s too large",
+			   reader->lineno_at_last_token_start, context);
 
   return 0;
 }
 
 static const char *
-aiger_already_defined (aiger * public, aiger_reader * reader, unsigned lit)
+aiger_already_defined (aiger * public, aiger_reader * reader, aiger_lit lit)
 {
   IMPORT_private_FROM (public);
   aiger_type *type;
-  unsigned var;
+  aiger_lit var;
 
   assert (lit);
   assert (!aiger_sign (lit));
 
   var = aiger_lit2var (lit);
 
-  if (public->maxvar < var)
+  if (public->maxvar < var || private->visitor)
     return 0;
 
   type = private->types + var;
@@ -2073,12 +4248,28 @@ aiger_already_defined (aiger * public, aiger_reader * reader, unsigned lit)
   return 0;
 }
 
+static void
+aiger_copy_header (aiger_reader * reader, aiger_header * header)
+{
+  header->mode = reader->mode;
+  header->maxvar = reader->maxvar;
+  header->inputs = reader->inputs;
+  header->latches = reader->latches;
+  header->outputs = reader->outputs;
+  header->ands = reader->ands;
+  header->bad = reader->bad;
+  header->constraints = reader->constraints;
+  header->justice = reader->justice;
+  header->fairness = reader->fairness;
+}
+
 static const char *
 aiger_read_header (aiger * public, aiger_reader * reader)
 {
   IMPORT_private_FROM (public);
-  unsigned i, j, lit, next, reset;
-  unsigned * sizes, * lits;
+  const aiger_visitor *visitor = private->visitor;
+  aiger_lit lit, next, reset, * lits;
+  unsigned i, j, * sizes;
   const char *error;
   char ch;
 
@@ -2112,26 +4303,26 @@ aiger_read_header (aiger * public, aiger_reader * reader)
 
   if (aiger_read_literal (private, reader,
         "maximum variable index", &reader->maxvar, ' ', 0) ||
-      aiger_read_literal (private, reader,
+      aiger_read_count (private, reader,
         "number of inputs", &reader->inputs, ' ', 0) ||
-      aiger_read_literal (private, reader,
+      aiger_read_count (private, reader,
         "number latches", &reader->latches, ' ', 0) ||
-      aiger_read_literal (private, reader,
+      aiger_read_count (private, reader,
         "number of outputs", &reader->outputs, ' ', 0) ||
-      aiger_read_literal (private, reader,
+      aiger_read_count (private, reader,
         "number of and gates", &reader->ands, 0, &ch) ||
       (ch == ' ' &&
-       aiger_read_literal (private, reader,
+       aiger_read_count (private, reader,
          "number of bad state constraints", &reader->bad, 0, &ch)) ||
       (ch == ' ' &&
-       aiger_read_literal (private, reader,
+       aiger_read_count (private, reader,
          "number of invariant constraints",
 	 &reader->constraints, 0, &ch)) ||
       (ch == ' ' &&
-       aiger_read_literal (private, reader,
+       aiger_read_count (private, reader,
          "number of justice constraints", &reader->justice, 0, &ch)) ||
       (ch == ' ' &&
-       aiger_read_literal (private, reader,
+       aiger_read_count (private, reader,
          "number of fairness constraints", &reader->fairness, '\n', 0)))
     {
       assert (private->error);
@@ -2140,27 +4331,49 @@ aiger_read_header (aiger * public, aiger_reader * reader)
 
   if (reader->mode == aiger_binary_mode)
     {
-      i = reader->inputs;
-      i += reader->latches;
-      i += reader->ands;
+      lit = reader->inputs;
+      lit += reader->latches;
+      lit += reader->ands;
 
-      if (i != reader->maxvar)
+      if (lit != reader->maxvar)
 	return aiger_error_u (private,
 			      "line %u: invalid maximal variable index",
 			      reader->lineno);
     }
 
+  if (private->header)
+    {
+      aiger_copy_header (reader, private->header);
+      return 0;
+    }
+
   public->maxvar = reader->maxvar;
 
-  FIT (private->types, private->size_types, public->maxvar + 1);
-  FIT (public->inputs, private->size_inputs, reader->inputs);
-  FIT (public->latches, private->size_latches, reader->latches);
-  FIT (public->outputs, private->size_outputs, reader->outputs);
-  FIT (public->ands, private->size_ands, reader->ands);
-  FIT (public->bad, private->size_bad, reader->bad);
-  FIT (public->constraints, private->size_constraints, reader->constraints);
-  FIT (public->justice, private->size_justice, reader->justice);
-  FIT (public->fairness, private->size_fairness, reader->fairness);
+  if (visitor)
+    {
+      /* Nothing is stored, not even variable types.
+       */
+      aiger_copy_header (reader, &private->visited);
+      if (visitor->header)
+	visitor->header (visitor->state, &private->visited);
+    }
+  else
+    {
+      if (reader->mode == aiger_ascii_mode && public->compact)
+	{
+	  aiger_expand (public);
+	  reader->compact = 1;
+	}
+
+      aiger_reserve (public,
+		     reader->maxvar,
+		     reader->inputs,
+		     reader->latches,
+		     reader->outputs,
+		     private->skip_ands ? 0 : reader->ands,
+		     reader->bad,
+		     reader->constraints, reader->justice, reader->fairness);
+    }
 
   for (i = 0; i < reader->inputs; i++)
     {
@@ -2182,9 +4395,12 @@ aiger_read_header (aiger * public, aiger_reader * reader)
 	    return error;
 	}
       else
-	lit = 2 * (i + 1);
+	lit = 2 * ((aiger_lit) i + 1);
 
-      aiger_add_input (public, lit, 0);
+      if (!visitor)
+	aiger_add_input (public, lit, 0);
+      else if (visitor->input)
+	visitor->input (visitor->state, lit);
     }
 
   for (i = 0; i < reader->latches; i++)
@@ -2207,7 +4423,7 @@ aiger_read_header (aiger * public, aiger_reader * reader)
 	    return error;
 	}
       else
-	lit = 2 * (i + reader->inputs + 1);
+	lit = 2 * ((aiger_lit) i + reader->inputs + 1);
 
       error = aiger_read_literal (private, reader,
                 "next state literal", &next, 0, &ch);
@@ -2219,17 +4435,23 @@ aiger_read_header (aiger * public, aiger_reader * reader)
 			       "line %u: literal %u is not a valid literal",
 			       reader->lineno_at_last_token_start, next);
 
-      aiger_add_latch (public, lit, next, 0);
-
+      reset = 0;
       if (ch == ' ')
 	{
 	  error = aiger_read_literal (private, reader,
 	            "reset literal", &reset, '\n', 0);
 	  if (error)
 	    return error;
+	}
 
-	  aiger_add_reset (public, lit, reset);
+      if (!visitor)
+	{
+	  aiger_add_latch (public, lit, next, 0);
+	  if (reset)
+	    aiger_add_reset (public, lit, reset);
 	}
+      else if (visitor->latch)
+	visitor->latch (visitor->state, lit, next, reset);
     }
 
   for (i = 0; i < reader->outputs; i++)
@@ -2244,7 +4466,10 @@ aiger_read_header (aiger * public, aiger_reader * reader)
 			       "line %u: literal %u is not a valid output",
 			       reader->lineno_at_last_token_start, lit);
 
-      aiger_add_output (public, lit, 0);
+      if (!visitor)
+	aiger_add_output (public, lit, 0);
+      else if (visitor->output)
+	visitor->output (visitor->state, lit);
     }
 
   for (i = 0; i < reader->bad; i++)
@@ -2259,7 +4484,10 @@ aiger_read_header (aiger * public, aiger_reader * reader)
 			       "line %u: literal %u is not valid bad",
 			       reader->lineno_at_last_token_start, lit);
 
-      aiger_add_bad (public, lit, 0);
+      if (!visitor)
+	aiger_add_bad (public, lit, 0);
+      else if (visitor->bad)
+	visitor->bad (visitor->state, lit);
     }
 
   for (i = 0; i < reader->constraints; i++)
@@ -2274,7 +4502,10 @@ aiger_read_header (aiger * public, aiger_reader * reader)
 		 "line %u: literal %u is not a valid constraint",
 		 reader->lineno_at_last_token_start, lit);
 
-      aiger_add_constraint (public, lit, 0);
+      if (!visitor)
+	aiger_add_constraint (public, lit, 0);
+      else if (visitor->constraint)
+	visitor->constraint (visitor->state, lit);
     }
 
   if (reader->justice)
@@ -2282,7 +4513,7 @@ aiger_read_header (aiger * public, aiger_reader * reader)
       NEWN (sizes, reader->justice);
       error =  0;
       for (i = 0; !error && i < reader->justice; i++)
-	error = aiger_read_literal (private, reader,
+	error = aiger_read_count (private, reader,
 	          "justice constraint size", sizes + i, '\n', 0);
       for (i = 0; !error && i < reader->justice; i++)
 	{
@@ -2290,146 +4521,752 @@ aiger_read_header (aiger * public, aiger_reader * reader)
 	  for (j = 0; !error && j < sizes[i]; j++)
 	    error = aiger_read_literal (private, reader,
 	              "justice constraint literal", lits + j, '\n', 0);
-	  if (!error)
+	  if (!error && !visitor)
 	    aiger_add_justice (public, sizes[i], lits, 0);
+	  else if (!error && visitor->justice)
+	    visitor->justice (visitor->state, sizes[i], lits);
 	  DELETEN (lits, sizes[i]);
 	}
       DELETEN (sizes, reader->justice);
       if (error)
 	return error;
     }
-
-  for (i = 0; i < reader->fairness; i++)
+
+  for (i = 0; i < reader->fairness; i++)
+    {
+      error = aiger_read_literal (private, reader,
+                "fairness constraint literal", &lit, '\n', 0);
+      if (error)
+	return error;
+
+      if (aiger_lit2var (lit) > public->maxvar)
+	return aiger_error_uu (private,
+		 "line %u: literal %u is not valid fairness",
+		 reader->lineno_at_last_token_start, lit);
+
+      if (!visitor)
+	aiger_add_fairness (public, lit, 0);
+      else if (visitor->fairness)
+	visitor->fairness (visitor->state, lit);
+    }
+
+  reader->done_with_reading_header = 1;
+  reader->looks_like_aag = 1;
+
+  return 0;
+}
+
+static void
+aiger_visit_and (aiger_private * private,
+		 aiger_lit lhs, aiger_lit rhs0, aiger_lit rhs1)
+{
+  const aiger_visitor *visitor = private->visitor;
+  if (visitor->and_gate)
+    visitor->and_gate (visitor->state, lhs, rhs0, rhs1);
+}
+
+static const char *
+aiger_read_ascii (aiger * public, aiger_reader * reader)
+{
+  IMPORT_private_FROM (public);
+  aiger_lit lhs, rhs0, rhs1;
+  unsigned i;
+  const char *error;
+
+  for (i = 0; i < reader->ands; i++)
+    {
+      error = aiger_read_literal (private, reader,
+                "and gate left-hand side literal", &lhs, ' ', 0);
+      if (error)
+	return error;
+
+      if (!lhs || aiger_sign (lhs) || aiger_lit2var (lhs) > public->maxvar)
+	return aiger_error_uu (private,
+			       "line %u: "
+			       "literal %u is not a valid LHS of AND",
+			       reader->lineno_at_last_token_start, lhs);
+
+      error = aiger_already_defined (public, reader, lhs);
+      if (error)
+	return error;
+
+      error = aiger_read_literal (private, reader,
+                "and gate first right-hand side literal",
+		&rhs0, ' ', 0);
+      if (error)
+	return error;
+
+      if (aiger_lit2var (rhs0) > public->maxvar)
+	return aiger_error_uu (private,
+			       "line %u: literal %u is not a valid literal",
+			       reader->lineno_at_last_token_start, rhs0);
+
+      error = aiger_read_literal (private, reader,
+                "and gate first right-hand side literal",
+		&rhs1, '\n', 0);
+      if (error)
+	return error;
+
+      if (aiger_lit2var (rhs1) > public->maxvar)
+	return aiger_error_uu (private,
+			       "line %u: literal %u is not a valid literal",
+			       reader->lineno_at_last_token_start, rhs1);
+
+      if (private->visitor)
+	aiger_visit_and (private, lhs, rhs0, rhs1);
+      else
+	aiger_add_and (public, lhs, rhs0, rhs1);
+    }
+
+  return 0;
+}
+
+static const char *
+aiger_read_delta (aiger_private * private, aiger_reader * reader,
+		  aiger_lit *res_ptr)
+{
+  unsigned i, charno;
+  unsigned char ch;
+  aiger_lit res;
+
+  if (reader->ch == EOF)
+  UNEXPECTED_EOF:
+    return aiger_error_u (private,
+			  "character %u: unexpected end of file",
+			  reader->charno);
+  i = 0;
+  res = 0;
+  ch = reader->ch;
+
+  charno = reader->charno;
+
+  while ((ch & 0x80))
+    {
+      if (i == AIGER_MAX_DELTA_BYTES)
+      INVALID_CODE:
+	return aiger_error_u (private, "character %u: invalid code", charno);
+
+      res |= (aiger_lit) (ch & 0x7f) << (7 * i++);
+      aiger_next_ch (reader);
+      if (reader->ch == EOF)
+	goto UNEXPECTED_EOF;
+
+      ch = reader->ch;
+    }
+
+#ifdef AIGER_WIDE
+  if (i == AIGER_MAX_DELTA_BYTES ||
+      (i + 1 == AIGER_MAX_DELTA_BYTES && ch >= AIGER_LAST_DELTA_BYTE_LIMIT))
+    goto INVALID_CODE;
+#else
+  if (i == 5 && ch >= 8)
+    goto INVALID_CODE;
+#endif
+
+  res |= (aiger_lit) ch << (7 * i);
+  *res_ptr = res;
+
+  aiger_next_ch (reader);
+
+  return 0;
+}
+
+/*------------------------------------------------------------------------*/
+/* Decoding of many deltas at once directly from the input window.  Runs of
+ * bytes without continuation bits, which are very common, are widened with
+ * SIMD instructions if available ('-msse2' is the default on 'x86-64', for
+ * AVX2 compile with '-mavx2' or '-march=native').  Otherwise deltas are
+ * cut at their terminating bytes found through the SIMD mask.
+ */
+#define AIGER_BATCH 256		/* gates decoded per batch */
+
+/* Decode one delta at 'p' with the same limits as 'aiger_read_delta'.  If
+ * the delta is incomplete or does not fit into 'aiger_lit' the result is
+ * zero.  Otherwise it is the first byte after the delta.
+ */
+static const unsigned char *
+aiger_decode_delta (const unsigned char *p, const unsigned char *end,
+		    aiger_lit *res_ptr)
+{
+  aiger_lit res = 0;
+  unsigned char ch;
+  unsigned i = 0;
+
+  do
+    {
+      if (p == end || i == AIGER_MAX_DELTA_BYTES)
+	return 0;
+      ch = *p++;
+      if (i + 1 == AIGER_MAX_DELTA_BYTES && ch >= AIGER_LAST_DELTA_BYTE_LIMIT)
+	return 0;
+      res |= (aiger_lit) (ch & 0x7f) << (7 * i++);
+    }
+  while (ch & 0x80);
+
+  *res_ptr = res;
+
+  return p;
+}
+
+/* Decode at most 'max' deltas from '[p..end[' and return their number.
+ * The first byte not consumed is stored in '*next_ptr'.  Decoding stops
+ * early at incomplete or invalid codes, which are then handled by the
+ * scalar reader including proper error messages.
+ */
+static unsigned
+aiger_decode_deltas (const unsigned char *p, const unsigned char *end,
+		     aiger_lit *deltas, unsigned max,
+		     const unsigned char **next_ptr)
+{
+  const unsigned char *q;
+  unsigned n = 0;
+#if defined(AIGER_WIDE)
+  /* Deltas are widened to 32-bit lanes, thus no SIMD in wide mode.
+   */
+#elif defined(__AVX2__)
+  __m256i v;
+  __m128i lo, hi;
+  unsigned mask;
+#define AIGER_SIMD_WIDTH 32
+#elif defined(__SSE2__)
+  __m128i v, lo, hi, zero = _mm_setzero_si128 ();
+  unsigned mask;
+#define AIGER_SIMD_WIDTH 16
+#endif
+
+  while (n < max)
+    {
+#ifdef AIGER_SIMD_WIDTH
+      if (max - n >= AIGER_SIMD_WIDTH && end - p >= AIGER_SIMD_WIDTH)
+	{
+#if defined(__AVX2__)
+	  v = _mm256_loadu_si256 ((const __m256i *) p);
+	  mask = (unsigned) _mm256_movemask_epi8 (v);
+	  if (!mask)
+	    {
+	      lo = _mm256_castsi256_si128 (v);
+	      hi = _mm256_extracti128_si256 (v, 1);
+	      _mm256_storeu_si256 ((__m256i *) (deltas + n),
+				   _mm256_cvtepu8_epi32 (lo));
+	      _mm256_storeu_si256 ((__m256i *) (deltas + n + 8),
+				   _mm256_cvtepu8_epi32 (_mm_srli_si128
+							 (lo, 8)));
+	      _mm256_storeu_si256 ((__m256i *) (deltas + n + 16),
+				   _mm256_cvtepu8_epi32 (hi));
+	      _mm256_storeu_si256 ((__m256i *) (deltas + n + 24),
+				   _mm256_cvtepu8_epi32 (_mm_srli_si128
+							 (hi, 8)));
+	      p += 32;
+	      n += 32;
+	      continue;
+	    }
+#else
+	  v = _mm_loadu_si128 ((const __m128i *) p);
+	  mask = (unsigned) _mm_movemask_epi8 (v);
+	  if (!mask)
+	    {
+	      lo = _mm_unpacklo_epi8 (v, zero);
+	      hi = _mm_unpackhi_epi8 (v, zero);
+	      _mm_storeu_si128 ((__m128i *) (deltas + n),
+				_mm_unpacklo_epi16 (lo, zero));
+	      _mm_storeu_si128 ((__m128i *) (deltas + n + 4),
+				_mm_unpackhi_epi16 (lo, zero));
+	      _mm_storeu_si128 ((__m128i *) (deltas + n + 8),
+				_mm_unpacklo_epi16 (hi, zero));
+	      _mm_storeu_si128 ((__m128i *) (deltas + n + 12),
+				_mm_unpackhi_epi16 (hi, zero));
+	      p += 16;
+	      n += 16;
+	      continue;
+	    }
+#endif
+	  /* Mixed window.  Bits cleared in 'mask' are terminating bytes.
+	   * Cut out all deltas ending in the window without branching on
+	   * every single byte.
+	   */
+	  mask = ~mask;
+#if AIGER_SIMD_WIDTH < 32
+	  mask &= (1u << AIGER_SIMD_WIDTH) - 1;
+#endif
+	  if (!mask)
+	    break;		/* too long for a 32-bit code */
+	  q = p;
+	  while (mask)
+	    {
+	      unsigned pos = __builtin_ctz (mask), len;
+	      aiger_lit delta;
+	      const unsigned char *r = p + pos + 1;
+	      len = r - q;
+	      if (len == 1)
+		delta = q[0];
+	      else if (len == 2)
+		delta = (q[0] & 0x7f) | ((unsigned) q[1] << 7);
+	      else if (!(q = aiger_decode_delta (q, r, &delta)) || q != r)
+		{
+		  q = r - len;	/* let the scalar reader complain */
+		  break;
+		}
+	      deltas[n++] = delta;
+	      q = r;
+	      mask &= mask - 1;
+	    }
+	  if (q == p)
+	    break;
+	  p = q;
+	  continue;
+	}
+#endif
+      q = aiger_decode_delta (p, end, deltas + n);
+      if (!q)
+	break;
+      p = q;
+      n++;
+    }
+
+  *next_ptr = p;
+
+  return n;
+}
+
+/* Skip the already decoded input up to 'q' but update all the counters
+ * exactly as 'aiger_next_ch' would do for every single character.
+ */
+static void
+aiger_skip_to (aiger_reader * reader, const unsigned char *q)
+{
+  const unsigned char *p, *r;
+  unsigned newlines, suffix;
+
+  assert (reader->cursor <= q);
+  assert (q <= reader->end);
+
+  while (reader->cursor < q &&
+	 reader->done_with_reading_header && reader->looks_like_aag)
+    aiger_next_ch (reader);
+
+  p = reader->cursor;
+  if (p == q)
+    return;
+
+  newlines = 0;
+  for (r = p; r < q; r++)
+    newlines += (*r == '\n');
+
+  suffix = 0;
+  for (r = q - 1; r >= p; r--)
+    {
+      if (!isspace (*r) && isspace (r[-1]))
+	{
+	  reader->lineno_at_last_token_start =
+	    reader->lineno + newlines - suffix;
+	  break;
+	}
+      suffix += (*r == '\n');
+    }
+
+  reader->lineno += newlines;
+  reader->charno += q - p;
+  reader->cursor = q;
+  reader->ch = q[-1];
+}
+
+/* Decode up to 'AIGER_BATCH' gates directly from the input window and add
+ * them.  Returns the number of gates added, which is zero if the window
+ * does not contain enough bytes or the first gate is invalid.
+ */
+static unsigned
+aiger_read_binary_batch (aiger * public, aiger_reader * reader,
+			 aiger_lit lhs, unsigned remaining)
+{
+  aiger_lit deltas[2 * AIGER_BATCH], rhs0, rhs1;
+  unsigned n, g, max;
+  const unsigned char *p, *q;
+  IMPORT_private_FROM (public);
+  aiger_type *type;
+  aiger_and *and;
+
+  p = reader->cursor - 1;	/* 'reader->ch' is the first byte */
+  assert (*p == reader->ch);
+
+  max = (remaining < AIGER_BATCH) ? 2 * remaining : 2 * AIGER_BATCH;
+  n = aiger_decode_deltas (p, reader->end, deltas, max, &q);
+
+  for (g = 0; 2 * g + 1 < n; g++)
+    {
+      lhs += 2;
+      if (deltas[2 * g] > lhs)
+	break;
+      rhs0 = lhs - deltas[2 * g];
+      if (deltas[2 * g + 1] > rhs0)
+	break;
+      rhs1 = rhs0 - deltas[2 * g + 1];
+
+      if (private->visitor)
+	{
+	  aiger_visit_and (private, lhs, rhs0, rhs1);
+	  continue;
+	}
+
+      assert (public->num_ands < private->size_ands);
+      if (public->compact)
+	{
+	  public->rhs0s[public->num_ands] = rhs0;
+	  public->rhs1s[public->num_ands] = rhs1;
+	}
+      else
+	{
+	  and = public->ands + public->num_ands;
+	  and->lhs = lhs;
+	  and->rhs0 = rhs0;
+	  and->rhs1 = rhs1;
+	}
+
+      type = private->types + aiger_lit2var (lhs);
+      assert (!type->input && !type->latch && !type->and);
+      type->and = 1;
+      type->idx = public->num_ands++;
+    }
+
+  if (!g)
+    return 0;
+
+  if (2 * g < n)
+    {
+      /* Position right after the last delta of gate 'g - 1'.
+       */
+      for (q = p, n = 0; n < 2 * g; q++)
+	n += (*q < 0x80);
+    }
+
+  aiger_skip_to (reader, q);
+  aiger_next_ch (reader);
+
+  return g;
+}
+
+#ifdef AIGER_HAVE_PTHREAD
+
+/*------------------------------------------------------------------------*/
+/* Multi-threaded decoding of the binary AND section for 'aiger_read_parallel'.
+ * Each delta ends with a byte smaller than 0x80.  Thus after counting these
+ * terminating bytes in parallel for chunks of the input, every thread knows
+ * the global index of the deltas starting in its chunk and can decode them
+ * independently into the preallocated 'ands' slots.  The second delta of a
+ * gate depends on the first one, which is resolved in a last pass over the
+ * gates.  If anything is wrong we let the sequential decoder do the work
+ * again, which then produces the proper error message.
+ */
+typedef struct aiger_chunk aiger_chunk;
+typedef struct aiger_decoder aiger_decoder;
+
+struct aiger_decoder
+{
+  aiger_private *private;
+  const unsigned char *start;	/* first byte of the AND section */
+  size_t bytes;			/* bytes in the AND section */
+  aiger_lit first_lhs;		/* LHS of the first AND */
+  unsigned num_ands;
+};
+
+struct aiger_chunk
+{
+  aiger_decoder *decoder;
+  size_t begin, end;		/* byte range [begin..end[ */
+  size_t first_delta;		/* deltas ending before 'begin' */
+  size_t terminators;		/* number of bytes < 0x80 in chunk */
+  unsigned begin_and, end_and;	/* gate range [begin_and..end_and[ */
+  int invalid;
+};
+
+static void *
+aiger_count_terminators (void *ptr)
+{
+  aiger_chunk *chunk = ptr;
+  const unsigned char *p, *end;
+  size_t res = 0;
+
+  p = chunk->decoder->start + chunk->begin;
+  end = chunk->decoder->start + chunk->end;
+  while (p < end)
+    res += (*p++ < 0x80);
+
+  chunk->terminators = res;
+
+  return 0;
+}
+
+static void *
+aiger_decode_chunk (void *ptr)
+{
+  aiger_chunk *chunk = ptr;
+  aiger_decoder *decoder = chunk->decoder;
+  const unsigned char *p, *start, *end, *limit;
+  aiger *public = &decoder->private->public;
+  aiger_lit delta, lhs;
+  size_t idx;
+  unsigned char ch;
+  int i;
+
+  start = decoder->start;
+  end = start + chunk->end;
+  limit = start + decoder->bytes;
+
+  /* Skip the tail of a delta started in the previous chunk including its
+   * terminating byte.
+   */
+  idx = chunk->first_delta;
+  p = start + chunk->begin;
+  if (p > start && p[-1] >= 0x80)
+    {
+      while (p < end && p[-1] >= 0x80)
+	p++;
+      idx++;
+    }
+  while (p < end)
     {
-      error = aiger_read_literal (private, reader,
-                "fairness constraint literal", &lit, '\n', 0);
-      if (error)
-	return error;
-
-      if (aiger_lit2var (lit) > public->maxvar)
-	return aiger_error_uu (private,
-		 "line %u: literal %u is not valid fairness",
-		 reader->lineno_at_last_token_start, lit);
+      delta = 0;
+      i = 0;
+      while ((ch = *p++) & 0x80)
+	{
+	  if (i + 1 == AIGER_MAX_DELTA_BYTES || p == limit)
+	    goto INVALID;
+	  delta |= (aiger_lit) (ch & 0x7f) << (7 * i++);
+	}
+      if (i + 1 == AIGER_MAX_DELTA_BYTES && ch >= AIGER_LAST_DELTA_BYTE_LIMIT)
+	goto INVALID;
+      delta |= (aiger_lit) ch << (7 * i);
 
-      aiger_add_fairness (public, lit, 0);
+      if (idx & 1)		/* resolved in 'aiger_resolve_ands' */
+	{
+	  if (public->compact)
+	    public->rhs1s[idx / 2] = delta;
+	  else
+	    public->ands[idx / 2].rhs1 = delta;
+	}
+      else
+	{
+	  lhs = decoder->first_lhs + 2 * (aiger_lit) (idx / 2);
+	  if (delta > lhs)
+	    goto INVALID;
+	  if (public->compact)
+	    public->rhs0s[idx / 2] = lhs - delta;
+	  else
+	    {
+	      public->ands[idx / 2].lhs = lhs;
+	      public->ands[idx / 2].rhs0 = lhs - delta;
+	    }
+	}
+      idx++;
     }
 
-  reader->done_with_reading_header = 1;
-  reader->looks_like_aag = 1;
+  return 0;
 
+INVALID:
+  chunk->invalid = 1;
   return 0;
 }
 
-static const char *
-aiger_read_ascii (aiger * public, aiger_reader * reader)
+static void *
+aiger_resolve_ands (void *ptr)
 {
-  IMPORT_private_FROM (public);
-  unsigned i, lhs, rhs0, rhs1;
-  const char *error;
+  aiger_chunk *chunk = ptr;
+  aiger_private *private = chunk->decoder->private;
+  aiger *public = &private->public;
+  aiger_lit lhs, rhs0, *rhs1;
+  aiger_type *type;
+  unsigned i;
 
-  for (i = 0; i < reader->ands; i++)
+  lhs = chunk->decoder->first_lhs + 2 * (aiger_lit) chunk->begin_and;
+  for (i = chunk->begin_and; i < chunk->end_and; i++, lhs += 2)
     {
-      error = aiger_read_literal (private, reader,
-                "and gate left-hand side literal", &lhs, ' ', 0);
-      if (error)
-	return error;
+      if (public->compact)
+	{
+	  rhs0 = public->rhs0s[i];
+	  rhs1 = public->rhs1s + i;
+	}
+      else
+	{
+	  rhs0 = public->ands[i].rhs0;
+	  rhs1 = &public->ands[i].rhs1;
+	}
+      if (*rhs1 > rhs0)
+	{
+	  chunk->invalid = 1;
+	  return 0;
+	}
+      *rhs1 = rhs0 - *rhs1;
+      type = private->types + aiger_lit2var (lhs);
+      assert (!type->input && !type->latch && !type->and);
+      type->and = 1;
+      type->idx = i;
+    }
 
-      if (!lhs || aiger_sign (lhs) || aiger_lit2var (lhs) > public->maxvar)
-	return aiger_error_uu (private,
-			       "line %u: "
-			       "literal %u is not a valid LHS of AND",
-			       reader->lineno_at_last_token_start, lhs);
+  return 0;
+}
 
-      error = aiger_already_defined (public, reader, lhs);
-      if (error)
-	return error;
+/* Returns non zero if the AND section was decoded completely and
+ * correctly.  The reader is then positioned right after the section.
+ */
+static int
+aiger_read_binary_parallel (aiger * public, aiger_reader * reader)
+{
+  IMPORT_private_FROM (public);
+  size_t bytes, max_bytes, count, needed, pos;
+  const unsigned char *start, *p;
+  unsigned i, threads;
+  aiger_lit first;
+  aiger_decoder decoder;
+  aiger_chunk *chunks;
+  int ok;
+
+  if (reader->get || reader->get_block || reader->ch == EOF)
+    return 0;
 
-      error = aiger_read_literal (private, reader,
-                "and gate first right-hand side literal",
-		&rhs0, ' ', 0);
-      if (error)
-	return error;
+  threads = reader->threads;
+  if (reader->ands / 1024 < threads)
+    return 0;
 
-      if (aiger_lit2var (rhs0) > public->maxvar)
-	return aiger_error_uu (private,
-			       "line %u: literal %u is not a valid literal",
-			       reader->lineno_at_last_token_start, rhs0);
+  start = reader->cursor - 1;	/* 'reader->ch' is the first byte */
+  assert (*start == reader->ch);
 
-      error = aiger_read_literal (private, reader,
-                "and gate first right-hand side literal",
-		&rhs1, '\n', 0);
-      if (error)
-	return error;
+  bytes = reader->end - start;
+  max_bytes = 2 * AIGER_MAX_DELTA_BYTES * (size_t) reader->ands;
+  if (bytes > max_bytes)
+    bytes = max_bytes;
 
-      if (aiger_lit2var (rhs1) > public->maxvar)
-	return aiger_error_uu (private,
-			       "line %u: literal %u is not a valid literal",
-			       reader->lineno_at_last_token_start, rhs1);
+  NEWN (chunks, threads);
+  CLR (decoder);
+  decoder.private = private;
+  decoder.start = start;
+  decoder.bytes = bytes;
+  decoder.first_lhs = aiger_max_input_or_latch (public) + 2;
+  decoder.num_ands = reader->ands;
 
-      aiger_add_and (public, lhs, rhs0, rhs1);
+  for (i = 0; i < threads; i++)
+    {
+      chunks[i].decoder = &decoder;
+      chunks[i].begin = (bytes / threads) * i;
+      chunks[i].end = (i + 1 == threads) ? bytes : (bytes / threads) * (i + 1);
     }
 
-  return 0;
-}
+  ok = aiger_run_chunks (private, chunks, sizeof *chunks, threads,
+			 aiger_count_terminators);
 
-static const char *
-aiger_read_delta (aiger_private * private, aiger_reader * reader,
-		  unsigned *res_ptr)
-{
-  unsigned res, i, charno;
-  unsigned char ch;
+  /* Determine the end of the section after '2 * ands' terminating bytes
+   * and drop chunks beyond it.
+   */
+  needed = 2 * (size_t) reader->ands;
+  count = 0;
+  for (i = 0; ok && i < threads; i++)
+    {
+      chunks[i].first_delta = count;
+      if (count + chunks[i].terminators >= needed)
+	break;
+      count += chunks[i].terminators;
+    }
 
-  if (reader->ch == EOF)
-  UNEXPECTED_EOF:
-    return aiger_error_u (private,
-			  "character %u: unexpected end of file",
-			  reader->charno);
-  i = 0;
-  res = 0;
-  ch = reader->ch;
+  if (ok && i < threads)
+    {
+      pos = chunks[i].begin;
+      for (p = start + pos; count < needed; p++)
+	count += (*p < 0x80);
+      decoder.bytes = bytes = p - start;
+      chunks[i].end = bytes;
+      threads = i + 1;
+    }
+  else
+    ok = 0;
 
-  charno = reader->charno;
+  if (ok)
+    ok = aiger_run_chunks (private, chunks, sizeof *chunks, threads,
+			   aiger_decode_chunk);
 
-  while ((ch & 0x80))
+  for (i = 0; ok && i < threads; i++)
+    ok = !chunks[i].invalid;
+
+  if (ok)
     {
-      assert (sizeof (unsigned) == 4);
+      threads = reader->threads;
+      for (i = 0; i < threads; i++)
+	{
+	  chunks[i].begin_and = (reader->ands / threads) * i;
+	  chunks[i].end_and = (i + 1 == threads) ?
+	    reader->ands : (reader->ands / threads) * (i + 1);
+	  chunks[i].invalid = 0;
+	}
 
-      if (i == 5)
-      INVALID_CODE:
-	return aiger_error_u (private, "character %u: invalid code", charno);
+      ok = aiger_run_chunks (private, chunks, sizeof *chunks, threads,
+			     aiger_resolve_ands);
 
-      res |= (ch & 0x7f) << (7 * i++);
-      aiger_next_ch (reader);
-      if (reader->ch == EOF)
-	goto UNEXPECTED_EOF;
+      for (i = 0; ok && i < threads; i++)
+	ok = !chunks[i].invalid;
 
-      ch = reader->ch;
+      if (!ok)			/* undo 'aiger_resolve_ands' */
+	{
+	  first = aiger_lit2var (decoder.first_lhs);
+	  for (i = 0; i < reader->ands; i++)
+	    {
+	      aiger_type *type = private->types + first + i;
+	      if (type->and && type->idx == i)
+		type->and = type->idx = 0;
+	    }
+	}
     }
 
-  if (i == 5 && ch >= 8)
-    goto INVALID_CODE;
+  DELETEN (chunks, reader->threads);
 
-  res |= ch << (7 * i);
-  *res_ptr = res;
+  if (!ok)
+    return 0;
 
+  public->num_ands = reader->ands;
+
+  /* Finally skip the section at once.  Delta bytes might still be '\n',
+   * which 'aiger_skip_to' counts in a simple loop to keep line numbers
+   * the same as with the sequential reader.
+   */
+  aiger_skip_to (reader, start + bytes);
   aiger_next_ch (reader);
 
-  return 0;
+  return 1;
 }
 
+#endif
+
 static const char *
 aiger_read_binary (aiger * public, aiger_reader * reader)
 {
-  unsigned i, lhs, rhs0, rhs1, delta, charno;
+  aiger_lit lhs, rhs0, rhs1, delta;
+  unsigned i, charno, batch;
   IMPORT_private_FROM (public);
   const char *error;
 
+#ifdef AIGER_HAVE_PTHREAD
+  if (reader->threads > 1 && !private->visitor &&
+      aiger_read_binary_parallel (public, reader))
+    return 0;
+#endif
+
   delta = 0;			/* avoid warning with -O3 */
 
-  lhs = aiger_max_input_or_latch (public);
+  lhs = 2 * ((aiger_lit) reader->inputs + reader->latches);
 
-  for (i = 0; i < reader->ands; i++)
+  i = 0;
+  while (i < reader->ands)
     {
+      if (!reader->get && reader->end - reader->cursor >= 16 &&
+	  reader->ch != EOF)
+	{
+	  batch = aiger_read_binary_batch (public, reader,
+					   lhs, reader->ands - i);
+	  if (batch)
+	    {
+	      i += batch;
+	      lhs += 2 * (aiger_lit) batch;
+	      continue;
+	    }
+	}
+
+      i++;
       lhs += 2;
       charno = reader->charno;
       error = aiger_read_delta (private, reader, &delta);
@@ -2452,57 +5289,87 @@ aiger_read_binary (aiger * public, aiger_reader * reader)
 
       rhs1 = rhs0 - delta;
 
-      aiger_add_and (public, lhs, rhs0, rhs1);
+      if (private->visitor)
+	aiger_visit_and (private, lhs, rhs0, rhs1);
+      else
+	aiger_add_and (public, lhs, rhs0, rhs1);
     }
 
   return 0;
 }
 
-static void
-aiger_reader_push_ch (aiger_private * private, aiger_reader * reader, char ch)
+
+/* The reader runs over the writable 'section' buffer.  Terminate the line
+ * starting at the current character in place and move to the next line.
+ * Returns zero if there is no new line before the end of the section.
+ */
+static char *
+aiger_read_line_in_place (aiger_reader * reader)
 {
-  PUSH (reader->buffer, reader->top_buffer, reader->size_buffer, ch);
+  char *res, *end;
+
+  assert (!reader->get && !reader->get_block);
+
+  if (reader->ch == EOF)
+    return 0;
+
+  res = (char *) reader->cursor - 1;
+  end = memchr (res, '\n', (char *) reader->end - res);
+  if (!end)
+    {
+      aiger_skip_to (reader, reader->end);
+      aiger_next_ch (reader);
+      return 0;
+    }
+
+  aiger_skip_to (reader, (unsigned char *) end + 1);
+  aiger_next_ch (reader);
+  *end = 0;
+
+  return res;
 }
 
 static const char *
 aiger_read_comments (aiger * public, aiger_reader * reader)
 {
   IMPORT_private_FROM (public);
+  char *comment;
+
   assert( reader->ch == '\n' );
 
   aiger_next_ch (reader);
 
   while (reader->ch != EOF)
     {
-      while (reader->ch != '\n')
-	{
-	  aiger_reader_push_ch (private, reader, reader->ch);
-	  aiger_next_ch (reader);
-
-	  if (reader->ch == EOF)
-	    return aiger_error_u (private,
-				  "line %u: new line after comment missing",
-				  reader->lineno);
-	}
+      comment = aiger_read_line_in_place (reader);
+      if (!comment)
+	return aiger_error_u (private,
+			      "line %u: new line after comment missing",
+			      reader->lineno);
 
-      aiger_next_ch (reader);
-      aiger_reader_push_ch (private, reader, 0);
-      aiger_add_comment (public, reader->buffer);
-      reader->top_buffer = 0;
+      if (!private->visitor)
+	aiger_push_comment (private, comment);
+      else if (private->visitor->comment)
+	private->visitor->comment (private->visitor->state, comment);
     }
 
   return 0;
 }
 
+/* Parse the captured section, which is called directly after reading or
+ * later through 'aiger_load_symbols'.
+ */
 static const char *
 aiger_read_symbols_and_comments (aiger * public, aiger_reader * reader)
 {
   IMPORT_private_FROM (public);
+  const aiger_visitor *visitor = private->visitor;
   const char *error, *type_name, * type_pos;
-  unsigned pos, num, count;
+  aiger_lit pos;
+  unsigned num, count;
   aiger_symbol *symbol;
+  char type, *name;
   
-  assert (!reader->buffer);
 
   for (count = 0;; count++)
     {
@@ -2536,7 +5403,9 @@ aiger_read_symbols_and_comments (aiger * public, aiger_reader * reader)
 
 	  type_name = "constraint";
 	  type_pos = "constraint";
-	  num = public->num_constraints;
+	  type = 'c';
+	  num = visitor ? private->visited.constraints :
+	    public->num_constraints;
 	  symbol = public->constraints;
 
 	  if (!num)
@@ -2552,35 +5421,40 @@ aiger_read_symbols_and_comments (aiger * public, aiger_reader * reader)
 	    {
 	      type_name = "input";
 	      type_pos = "input";
-	      num = public->num_inputs;
+	      type = 'i';
+	      num = visitor ? private->visited.inputs : public->num_inputs;
 	      symbol = public->inputs;
 	    }
 	  else if (reader->ch == 'l')
 	    {
 	      type_name = "latch";
 	      type_pos = "latch";
-	      num = public->num_latches;
+	      type = 'l';
+	      num = visitor ? private->visited.latches : public->num_latches;
 	      symbol = public->latches;
 	    }
 	  else if (reader->ch == 'o')
 	    {
 	      type_name = "output";
 	      type_pos = "output";
-	      num = public->num_outputs;
+	      type = 'o';
+	      num = visitor ? private->visited.outputs : public->num_outputs;
 	      symbol = public->outputs;
 	    }
 	  else if (reader->ch == 'b')
 	    {
 	      type_name = "bad";
 	      type_pos = "bad";
-	      num = public->num_bad;
+	      type = 'b';
+	      num = visitor ? private->visited.bad : public->num_bad;
 	      symbol = public->bad;
 	    }     
 	  else if (reader->ch == 'j')
 	    {
 	      type_name = "justice";
 	      type_pos = "justice";
-	      num = public->num_justice;
+	      type = 'j';
+	      num = visitor ? private->visited.justice : public->num_justice;
 	      symbol = public->justice;
 	    }
 	  else
@@ -2588,114 +5462,544 @@ aiger_read_symbols_and_comments (aiger * public, aiger_reader * reader)
 	      assert (reader->ch == 'f');
 	      type_name = "fairness";
 	      type_pos = "fairness";
-	      num = public->num_fairness;
+	      type = 'f';
+	      num = visitor ? private->visited.fairness : public->num_fairness;
 	      symbol = public->fairness;
 	    }
 
-	  aiger_next_ch (reader);
+	  aiger_next_ch (reader);
+	}
+
+      error = aiger_read_literal (private, reader,
+                type_pos, &pos, ' ', 0);
+      if (error)
+	return error;
+
+      if (pos >= num)
+	return aiger_error_usu (private,
+		 "line %u: "
+		 "%s symbol table entry position %u too large",
+		 reader->lineno_at_last_token_start, type_name, pos);
+
+      if (visitor)
+	{
+	  name = aiger_read_line_in_place (reader);
+	  if (!name)
+	    return aiger_error_u (private,
+				  "line %u: new line missing", reader->lineno);
+	  if (visitor->symbol)
+	    visitor->symbol (visitor->state, type, pos, name);
+	  continue;
+	}
+
+      symbol += pos;
+
+      if (symbol->name)
+	return aiger_error_usu (private,
+				"line %u: %s literal %u has multiple symbols",
+				reader->lineno_at_last_token_start, type_name,
+				symbol->lit);
+
+      symbol->name = aiger_read_line_in_place (reader);
+      if (!symbol->name)
+	return aiger_error_u (private,
+			      "line %u: new line missing", reader->lineno);
+    }
+}
+
+static void
+aiger_section_append (aiger_private * private,
+		      const unsigned char *bytes, size_t n)
+{
+  aiger_section *section = &private->section;
+  size_t new_size;
+
+  if (section->size - section->bytes < n)
+    {
+      new_size = section->size ? 2 * section->size : AIGER_BLOCK_SIZE;
+      while (new_size - section->bytes < n)
+	new_size *= 2;
+      REALLOCN (section->start, section->size, new_size);
+      section->size = new_size;
+    }
+
+  memcpy (section->start + section->bytes, bytes, n);
+  section->bytes += n;
+}
+
+/* Copy the rest of the input after the AND section into 'section' and
+ * remember the reader state for parsing it later.  Memory windows are
+ * copied as a whole and only other readers go through 'aiger_next_ch'.
+ */
+static const char *
+aiger_capture_section (aiger * public, aiger_reader * reader)
+{
+  IMPORT_private_FROM (public);
+  aiger_section *section = &private->section;
+  unsigned char ch;
+
+  assert (!section->start);
+  assert (!aiger_error (public));
+
+  section->lineno = reader->lineno;
+  section->charno = reader->charno;
+  section->lineno_at_last_token_start = reader->lineno_at_last_token_start;
+  section->looks_like_aag = reader->looks_like_aag;
+
+  if (reader->ch == EOF)
+    return 0;
+
+  if (!reader->get && !reader->get_block)
+    {
+      assert (reader->cursor[-1] == reader->ch);
+      section->size = reader->end - reader->cursor + 1;
+      NEWN (section->start, section->size);
+    }
+
+  while (reader->ch != EOF)
+    {
+      if (!reader->get && reader->cursor <= reader->end)
+	{
+	  aiger_section_append (private, reader->cursor - 1,
+				reader->end - reader->cursor + 1);
+	  reader->cursor = reader->end;
+	}
+      else
+	{
+	  ch = reader->ch;
+	  aiger_section_append (private, &ch, 1);
+	}
+      aiger_next_ch (reader);
+    }
+
+  section->pending = 1;
+
+  return 0;
+}
+
+/* Find the position after the '*todo_ptr'-th terminating byte in '[p,end['
+ * or 'end' if there are less.  Terminating bytes are those smaller than
+ * 'limit' or new lines if 'limit' is zero.  Whole blocks are counted first,
+ * which is easy to vectorize, before searching for the exact position.
+ */
+static const unsigned char *
+aiger_skip_terminators (const unsigned char *p, const unsigned char *end,
+			unsigned char limit, size_t *todo_ptr)
+{
+  size_t todo = *todo_ptr, count, bytes, i;
+
+  while (todo && p < end)
+    {
+      bytes = end - p;
+      if (bytes > 4096)
+	bytes = 4096;
+
+      count = 0;
+      if (limit)
+	for (i = 0; i < bytes; i++)
+	  count += (p[i] < limit);
+      else
+	for (i = 0; i < bytes; i++)
+	  count += (p[i] == '\n');
+
+      if (count < todo)
+	{
+	  todo -= count;
+	  p += bytes;
+	  continue;
+	}
+
+      for (i = 0; todo; i++)
+	if (limit ? (p[i] < limit) : (p[i] == '\n'))
+	  todo--;
+
+      p += i;
+    }
+
+  *todo_ptr = todo;
+
+  return p;
+}
+
+/* Skip the AND section, i.e., 'ands' lines in ASCII mode or '2 * ands'
+ * bytes without continuation bit in binary mode, without decoding it.
+ */
+static const char *
+aiger_skip_and_section (aiger * public, aiger_reader * reader)
+{
+  IMPORT_private_FROM (public);
+  const unsigned char *p;
+  int binary, ch;
+  size_t todo;
+
+  binary = (reader->mode == aiger_binary_mode);
+  todo = reader->ands;
+  if (binary)
+    todo *= 2;
+
+  while (todo)
+    {
+      ch = reader->ch;
+      if (ch == EOF)
+	{
+	  if (binary)
+	    return aiger_error_u (private,
+				  "character %u: unexpected end of file",
+				  reader->charno);
+	  return aiger_error_u (private,
+				"line %u: unexpected end of file "
+				"in AND section", reader->lineno);
+	}
+
+      if (binary ? (ch < 0x80) : (ch == '\n'))
+	todo--;
+
+      if (todo && !reader->get && reader->cursor < reader->end)
+	{
+	  p = aiger_skip_terminators (reader->cursor, reader->end,
+				      binary ? 0x80 : 0, &todo);
+	  aiger_skip_to (reader, p);
 	}
 
-      error = aiger_read_literal (private, reader,
-                type_pos, &pos, ' ', 0);
-      if (error)
-	return error;
+      aiger_next_ch (reader);
+    }
 
-      if (pos >= num)
-	return aiger_error_usu (private,
-		 "line %u: "
-		 "%s symbol table entry position %u too large",
-		 reader->lineno_at_last_token_start, type_name, pos);
+  return 0;
+}
 
-      symbol += pos;
+static const char *
+aiger_read_with_reader (aiger * public, aiger_reader * reader)
+{
+  IMPORT_private_FROM (public);
+  const char *error;
 
-      if (symbol->name)
-	return aiger_error_usu (private,
-				"line %u: %s literal %u has multiple symbols",
-				reader->lineno_at_last_token_start, type_name,
-				symbol->lit);
+  aiger_invalidate (private);
 
-      while (reader->ch != '\n' && reader->ch != EOF)
-	{
-	  aiger_reader_push_ch (private, reader, reader->ch);
-	  aiger_next_ch (reader);
-	}
+  reader->lineno = 1;
+  reader->ch = ' ';
 
-      if (reader->ch == EOF)
-	return aiger_error_u (private,
-			      "line %u: new line missing", reader->lineno);
+  error = aiger_read_header (public, reader);
+  if (error)
+    return error;
 
-      assert (reader->ch == '\n');
-      aiger_next_ch (reader);
+  if (private->header)
+    return 0;
+
+  if (private->skip_ands)
+    error = aiger_skip_and_section (public, reader);
+  else if (reader->mode == aiger_ascii_mode)
+    error = aiger_read_ascii (public, reader);
+  else
+    error = aiger_read_binary (public, reader);
+
+  if (error)
+    return error;
+
+  error = aiger_capture_section (public, reader);
+  if (!error && (!private->lazy_symbols || private->visitor))
+    error = aiger_load_symbols (public);
 
-      aiger_reader_push_ch (private, reader, 0);
-      symbol->name = aiger_copy_str (private, reader->buffer);
-      reader->top_buffer = 0;
+
+  if (error)
+    return error;
+
+  if (private->visitor)
+    {
+      DELETEN (private->section.start, private->section.size);
+      CLR (private->section);
+      return 0;
     }
+
+  if (private->skip_ands)
+    return 0;
+
+  error = aiger_check (public);
+  if (!error && reader->compact)
+    aiger_compact (public);
+
+  return error;
 }
 
 const char *
-aiger_read_generic (aiger * public, void *state, aiger_get get)
+aiger_load_symbols (aiger * public)
 {
   IMPORT_private_FROM (public);
+  aiger_section *section = &private->section;
+  aiger_reader reader;
+
+  if (private->error)
+    return private->error;
+
+  if (!section->pending)
+    return 0;
+
+  section->pending = 0;
+
+  CLR (reader);
+  reader.cursor = (unsigned char *) section->start + 1;
+  reader.end = (unsigned char *) section->start + section->bytes;
+  reader.ch = section->start[0];
+  reader.lineno = section->lineno;
+  reader.charno = section->charno;
+  reader.lineno_at_last_token_start = section->lineno_at_last_token_start;
+  reader.looks_like_aag = section->looks_like_aag;
+  reader.done_with_reading_header = 1;
+
+  return aiger_read_symbols_and_comments (public, &reader);
+}
+
+void
+aiger_lazy_symbols (aiger * public)
+{
+  IMPORT_private_FROM (public);
+  private->lazy_symbols = 1;
+}
+
+const char *
+aiger_read_header_only (aiger * public, const char *file_name,
+			aiger_header * header)
+{
+  IMPORT_private_FROM (public);
+  const char *res;
+
+  assert (!aiger_error (public));
+  assert (!private->header);
+
+  private->header = header;
+  res = aiger_open_and_read_from_file (public, file_name);
+  private->header = 0;
+
+  return res;
+}
+
+void
+aiger_skip_ands (aiger * public)
+{
+  IMPORT_private_FROM (public);
+  private->skip_ands = 1;
+}
+
+void
+aiger_set_visitor (aiger * public, const aiger_visitor * visitor)
+{
+  IMPORT_private_FROM (public);
+  private->visitor = visitor;
+}
+
+void
+aiger_write_threads (aiger * public, unsigned threads)
+{
+  IMPORT_private_FROM (public);
+  private->write_threads = threads;
+}
+
+const char *
+aiger_read_generic (aiger * public, void *state, aiger_get get)
+{
   aiger_reader reader;
-  const char *error;
 
   assert (!aiger_error (public));
 
   CLR (reader);
 
-  reader.lineno = 1;
   reader.state = state;
   reader.get = get;
-  reader.ch = ' ';
 
-  error = aiger_read_header (public, &reader);
-  if (error)
-    return error;
+  return aiger_read_with_reader (public, &reader);
+}
 
-  if (reader.mode == aiger_ascii_mode)
-    error = aiger_read_ascii (public, &reader);
-  else
-    error = aiger_read_binary (public, &reader);
+const char *
+aiger_read_blocks (aiger * public, void *state, aiger_get_block get_block)
+{
+  IMPORT_private_FROM (public);
+  aiger_reader reader;
+  const char *res;
 
-  if (error)
-    return error;
+  assert (!aiger_error (public));
+
+  CLR (reader);
 
-  error = aiger_read_symbols_and_comments (public, &reader);
+  reader.state = state;
+  reader.get_block = get_block;
+  NEWN (reader.block, AIGER_BLOCK_SIZE);
 
-  DELETEN (reader.buffer, reader.size_buffer);
+  res = aiger_read_with_reader (public, &reader);
 
-  if (error)
-    return error;
+  DELETEN (reader.block, AIGER_BLOCK_SIZE);
+
+  return res;
+}
+
+/* Parse directly from a memory buffer without going through any character
+ * call-back function, which is used for memory mapped files.
+ */
+static const char *
+aiger_read_from_memory (aiger * public,
+			const void *start, size_t bytes, unsigned threads)
+{
+  aiger_reader reader;
 
-  return aiger_check (public);
+  assert (!aiger_error (public));
+
+  CLR (reader);
+
+  reader.cursor = start;
+  reader.end = reader.cursor + bytes;
+  reader.threads = threads;
+
+  return aiger_read_with_reader (public, &reader);
+}
+
+/* Try to map the file into memory.  Returns non zero if this succeeded, in
+ * which case the result of parsing is stored in '*res_ptr'.  Otherwise,
+ * e.g., for pipes, devices and empty files, the caller has to fall back to
+ * reading through 'stdio'.
+ */
+static int
+aiger_read_from_mapped_file (aiger * public,
+                             const char *file_name, const char **res_ptr)
+{
+  struct stat buf;
+  size_t bytes;
+  void *start;
+  int fd;
+
+  fd = open (file_name, O_RDONLY);
+  if (fd < 0)
+    return 0;
+
+  if (fstat (fd, &buf) || !S_ISREG (buf.st_mode) || buf.st_size <= 0 ||
+      (off_t) (size_t) buf.st_size != buf.st_size)
+    {
+      close (fd);
+      return 0;
+    }
+
+  bytes = buf.st_size;
+  start = mmap (0, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+  close (fd);
+
+  if (start == MAP_FAILED)
+    return 0;
+
+#ifdef MADV_SEQUENTIAL
+  madvise (start, bytes, MADV_SEQUENTIAL);
+#endif
+  *res_ptr = aiger_read_from_memory (public, start, bytes, 1);
+  munmap (start, bytes);
+
+  return 1;
 }
 
 const char *
 aiger_read_from_file (aiger * public, FILE * file)
 {
   assert (!aiger_error (public));
-  return aiger_read_generic (public, file, (aiger_get) aiger_default_get);
+  return aiger_read_blocks (public,
+			    file, (aiger_get_block) aiger_file_get_block);
+}
+
+const char *
+aiger_read_parallel (aiger * public, FILE * file, unsigned threads)
+{
+  IMPORT_private_FROM (public);
+  size_t bytes, size, count;
+  struct stat buf;
+  const char *res;
+  char *start;
+  off_t pos;
+
+  assert (!aiger_error (public));
+
+  if (!threads)
+    threads = 1;
+
+  /* Map regular files into memory, starting at the current position.
+   */
+  if (!fstat (fileno (file), &buf) && S_ISREG (buf.st_mode) &&
+      (pos = ftello (file)) >= 0 && pos < buf.st_size &&
+      (off_t) (size_t) buf.st_size == buf.st_size)
+    {
+      bytes = buf.st_size;
+      start = mmap (0, bytes, PROT_READ, MAP_PRIVATE, fileno (file), 0);
+      if (start != MAP_FAILED)
+	{
+	  res = aiger_read_from_memory (public,
+					start + pos, bytes - pos, threads);
+	  munmap (start, bytes);
+	  fseeko (file, 0, SEEK_END);
+	  return res;
+	}
+    }
+
+  /* Otherwise read everything into a buffer first.
+   */
+  size = AIGER_BLOCK_SIZE;
+  NEWN (start, size);
+  bytes = 0;
+  while ((count = fread (start + bytes, 1, size - bytes, file)))
+    if ((bytes += count) == size)
+      ENLARGE (start, size);
+
+  res = aiger_read_from_memory (public, start, bytes, threads);
+  DELETEN (start, size);
+
+  return res;
 }
 
 const char *
 aiger_read_from_string (aiger * public, const char *str)
 {
-    assert (!aiger_error (public));
-    return aiger_read_generic (public, &str, (aiger_get) aiger_string_get);
+  assert (!aiger_error (public));
+  return aiger_read_blocks (public,
+			    &str, (aiger_get_block) aiger_string_get_block);
 }
 
 const char *
 aiger_open_and_read_from_file (aiger * public, const char *file_name)
 {
   IMPORT_private_FROM (public);
-  char *cmd, size_cmd;
   const char *res;
+  size_t size_cmd;
   int pclose_file;
   FILE *file;
+  char *cmd;
+#ifdef AIGER_HAVE_CODEC
+  aiger_zfile zfile;
+  int failed;
+#endif
 
   assert (!aiger_error (public));
 
+#ifdef AIGER_HAVE_CODEC
+  if (aiger_zfile_codec (file_name))
+    {
+      if (!aiger_zfile_open (private, &zfile, file_name, 0))
+	return aiger_error_s (private, "can not read '%s'", file_name);
+
+      res = aiger_read_blocks (public, &zfile,
+			       (aiger_get_block) aiger_zfile_get_block);
+
+      /* A failed decompression looks like a premature end-of-file to the
+       * parser.  Report the actual cause instead.
+       */
+      failed = zfile.failed;
+      if (!aiger_zfile_close (private, &zfile))
+	failed = 1;
+      if (failed)
+	{
+	  if (res)
+	    {
+	      aiger_delete_str (private, private->error);
+	      private->error = 0;
+	    }
+	  res = aiger_error_s (private, "failed to decompress '%s'",
+			       file_name);
+	}
+      return res;
+    }
+#endif
+
   if (aiger_has_suffix (file_name, ".gz"))
     {
       size_cmd = strlen (file_name) + strlen (GUNZIP);
@@ -2714,8 +6018,20 @@ aiger_open_and_read_from_file (aiger * public, const char *file_name)
       DELETEN (cmd, size_cmd);
       pclose_file = 1;
     }
+  else if (aiger_has_suffix (file_name, ".zst"))
+    {
+      size_cmd = strlen (file_name) + strlen (ZSTDUNZIP);
+      NEWN (cmd, size_cmd);
+      sprintf (cmd, ZSTDUNZIP, file_name);
+      file = popen (cmd, "r");
+      DELETEN (cmd, size_cmd);
+      pclose_file = 1;
+    }
   else
     {
+      if (aiger_read_from_mapped_file (public, file_name, &res))
+	return res;
+
       file = fopen (file_name, "rb");
       pclose_file = 0;
     }
@@ -2734,12 +6050,12 @@ aiger_open_and_read_from_file (aiger * public, const char *file_name)
 }
 
 const char *
-aiger_get_symbol (aiger const * public, unsigned lit)
+aiger_get_symbol (aiger const * public, aiger_lit lit)
 {
   IMPORT_const_private_FROM (public);
   aiger_symbol *symbol;
   aiger_type *type;
-  unsigned var;
+  aiger_lit var;
 
   assert (!aiger_error (public));
 
@@ -2750,6 +6066,9 @@ aiger_get_symbol (aiger const * public, unsigned lit)
   assert (var <= public->maxvar);
   type = private->types + var;
 
+  if (private->section.pending && aiger_load_symbols ((aiger *) public))
+    return 0;
+
   if (type->input)
     symbol = public->inputs;
   else if (type->latch)
@@ -2760,12 +6079,149 @@ aiger_get_symbol (aiger const * public, unsigned lit)
   return symbol[type->idx].name;
 }
 
+static unsigned
+aiger_hash_str (const char *str)
+{
+  unsigned res = 0;
+  const char *p;
+
+  for (p = str; *p; p++)
+    res = (res + (unsigned char) *p) * 1000000007u;
+
+  return res ^ (res >> 16);
+}
+
+static void
+aiger_insert_symbols (aiger_private * private, int tag,
+		      aiger_symbol * symbols, unsigned num_symbols)
+{
+  unsigned i, pos, hash, mask = private->size_symbol_table - 1;
+  aiger_symbol_entry *entry;
+  aiger_symbol *symbol;
+
+  for (i = 0; i < num_symbols; i++)
+    {
+      symbol = symbols + i;
+      if (!symbol->name)
+	continue;
+
+      hash = aiger_hash_str (symbol->name);
+      for (pos = hash & mask;; pos = (pos + 1) & mask)
+	{
+	  entry = private->symbol_table + pos;
+	  if (!entry->symbol)
+	    break;
+
+	  /* Keep the first symbol with the same name.
+	   */
+	  if (entry->hash == hash && !strcmp (entry->symbol->name,
+					      symbol->name))
+	    break;
+	}
+
+      if (entry->symbol)
+	continue;
+
+      entry->symbol = symbol;
+      entry->hash = hash;
+      entry->tag = tag;
+    }
+}
+
+static unsigned
+aiger_count_names (aiger_symbol * symbols, unsigned num_symbols)
+{
+  unsigned i, res = 0;
+
+  for (i = 0; i < num_symbols; i++)
+    if (symbols[i].name)
+      res++;
+
+  return res;
+}
+
+/* Build the table with at most half of the entries used.
+ */
+static void
+aiger_build_symbol_table (aiger * public)
+{
+  IMPORT_private_FROM (public);
+  unsigned count, size;
+
+  count = aiger_count_names (public->inputs, public->num_inputs);
+  count += aiger_count_names (public->latches, public->num_latches);
+  count += aiger_count_names (public->outputs, public->num_outputs);
+  count += aiger_count_names (public->bad, public->num_bad);
+  count += aiger_count_names (public->constraints, public->num_constraints);
+  count += aiger_count_names (public->justice, public->num_justice);
+  count += aiger_count_names (public->fairness, public->num_fairness);
+
+  for (size = 2; size < 2 * count; size *= 2)
+    ;
+
+  if (size != private->size_symbol_table)
+    {
+      DELETEN (private->symbol_table, private->size_symbol_table);
+      NEWN (private->symbol_table, size);
+      private->size_symbol_table = size;
+    }
+  else
+    memset (private->symbol_table, 0, size * sizeof *private->symbol_table);
+
+  aiger_insert_symbols (private, 'i', public->inputs, public->num_inputs);
+  aiger_insert_symbols (private, 'l', public->latches, public->num_latches);
+  aiger_insert_symbols (private, 'o', public->outputs, public->num_outputs);
+  aiger_insert_symbols (private, 'b', public->bad, public->num_bad);
+  aiger_insert_symbols (private, 'c',
+			public->constraints, public->num_constraints);
+  aiger_insert_symbols (private, 'j', public->justice, public->num_justice);
+  aiger_insert_symbols (private, 'f',
+			public->fairness, public->num_fairness);
+
+  private->symbol_table_cached = 1;
+}
+
+aiger_symbol *
+aiger_find_symbol (aiger * public, const char *name, int *tag_ptr)
+{
+  IMPORT_private_FROM (public);
+  unsigned pos, hash, mask;
+  aiger_symbol_entry *entry;
+
+  assert (!aiger_error (public));
+  assert (name);
+
+  if (aiger_load_symbols (public))
+    return 0;
+
+  if (!private->symbol_table_cached)
+    aiger_build_symbol_table (public);
+
+  hash = aiger_hash_str (name);
+  mask = private->size_symbol_table - 1;
+
+  for (pos = hash & mask;; pos = (pos + 1) & mask)
+    {
+      entry = private->symbol_table + pos;
+      if (!entry->symbol)
+	return 0;
+
+      if (entry->hash == hash && !strcmp (entry->symbol->name, name))
+	break;
+    }
+
+  if (tag_ptr)
+    *tag_ptr = entry->tag;
+
+  return entry->symbol;
+}
+
 static aiger_type *
-aiger_lit2type (aiger const * public, unsigned lit)
+aiger_lit2type (aiger const * public, aiger_lit lit)
 {
   IMPORT_const_private_FROM (public);
   aiger_type *type;
-  unsigned var;
+  aiger_lit var;
 
   var = aiger_lit2var (lit);
   assert (var <= public->maxvar);
@@ -2775,7 +6231,7 @@ aiger_lit2type (aiger const * public, unsigned lit)
 }
 
 int
-aiger_lit2tag (aiger const * public, unsigned lit)
+aiger_lit2tag (aiger const * public, aiger_lit lit)
 {
   aiger_type * type;
   lit = aiger_strip (lit);
@@ -2787,7 +6243,7 @@ aiger_lit2tag (aiger const * public, unsigned lit)
 }
 
 aiger_symbol *
-aiger_is_input (aiger const * public, unsigned lit)
+aiger_is_input (aiger const * public, aiger_lit lit)
 {
   aiger_type *type;
   aiger_symbol *res;
@@ -2803,7 +6259,7 @@ aiger_is_input (aiger const * public, unsigned lit)
 }
 
 aiger_symbol *
-aiger_is_latch (aiger const * public, unsigned lit)
+aiger_is_latch (aiger const * public, aiger_lit lit)
 {
   aiger_symbol *res;
   aiger_type *type;
@@ -2819,8 +6275,9 @@ aiger_is_latch (aiger const * public, unsigned lit)
 }
 
 aiger_and *
-aiger_is_and (aiger const * public, unsigned lit)
+aiger_is_and (aiger const * public, aiger_lit lit)
 {
+  IMPORT_private_FROM (public);
   aiger_type *type;
   aiger_and *res;
 
@@ -2829,7 +6286,15 @@ aiger_is_and (aiger const * public, unsigned lit)
   if (!type->and)
     return 0;
 
-  res = public->ands + type->idx;
+  if (public->compact)
+    {
+      res = &private->and;
+      res->lhs = aiger_and_lhs (public, type->idx);
+      res->rhs0 = aiger_and_rhs0 (public, type->idx);
+      res->rhs1 = aiger_and_rhs1 (public, type->idx);
+    }
+  else
+    res = public->ands + type->idx;
 
   return res;
 }
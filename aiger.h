@@ -46,6 +46,7 @@ extern "C" {
 typedef struct aiger aiger;
 typedef struct aiger_and aiger_and;
 typedef struct aiger_symbol aiger_symbol;
+typedef struct aiger_header aiger_header;
 
 /*------------------------------------------------------------------------*/
 /* AIG references are represented as unsigned integers and are called
@@ -57,17 +58,34 @@ typedef struct aiger_symbol aiger_symbol;
 #define aiger_false 0
 #define aiger_true 1
 
+/*------------------------------------------------------------------------*/
+/* Literals and variable indices are 32-bit 'unsigned' by default, which
+ * limits models to less than 2^31 variables.  If the library and all its
+ * clients are compiled with '-DAIGER_WIDE' they are 64-bit instead, and the
+ * binary format uses up to 10 bytes per delta.  The number of inputs,
+ * latches, ANDs etc. is still 'unsigned' in both cases.  Clients have to
+ * use 'aiger_lit' for literals passed by reference, e.g., to
+ * 'aiger_add_justice', and 'AIGER_LIT_FMT' to print them.
+ */
+#ifdef AIGER_WIDE
+typedef unsigned long long aiger_lit;
+#define AIGER_LIT_FMT "llu"
+#else
+typedef unsigned aiger_lit;
+#define AIGER_LIT_FMT "u"
+#endif
+
 #define aiger_is_constant(l) \
   ((l) == aiger_false || ((l) == aiger_true))
 
 #define aiger_sign(l) \
-  (((unsigned)(l))&1)
+  (((aiger_lit)(l))&1)
 
 #define aiger_strip(l) \
-  (((unsigned)(l))&~1)
+  (((aiger_lit)(l))&~(aiger_lit)1)
 
 #define aiger_not(l) \
-  (((unsigned)(l))^1)
+  (((aiger_lit)(l))^1)
 
 /*------------------------------------------------------------------------*/
 /* Each literal is associated to a variable having an unsigned index.  The
@@ -75,10 +93,10 @@ typedef struct aiger_symbol aiger_symbol;
  * the same as removing the sign bit.
  */
 #define aiger_var2lit(i) \
-  (((unsigned)(i)) << 1)
+  (((aiger_lit)(i)) << 1)
 
 #define aiger_lit2var(l) \
-  (((unsigned)(l)) >> 1)
+  (((aiger_lit)(l)) >> 1)
 
 /*------------------------------------------------------------------------*/
 /* Callback functions for client memory management.  The 'free' wrapper will
@@ -87,6 +105,10 @@ typedef struct aiger_symbol aiger_symbol;
 typedef void *(*aiger_malloc) (void *mem_mgr, size_t);
 typedef void (*aiger_free) (void *mem_mgr, void *ptr, size_t);
 
+/* The optional 'realloc' wrapper gets the old and the new size.
+ */
+typedef void *(*aiger_realloc) (void *mem_mgr, void *ptr, size_t, size_t);
+
 /*------------------------------------------------------------------------*/
 /* Callback function for client character stream reading.  It returns an
  * ASCII character or EOF.  Thus is has the same semantics as the standard
@@ -102,6 +124,21 @@ typedef int (*aiger_get) (void *client_state);
  */
 typedef int (*aiger_put) (char ch, void *client_state);
 
+/*------------------------------------------------------------------------*/
+/* Block-oriented versions of the previous two call-back functions.  They
+ * have the same semantics as 'fread' and 'fwrite' with element size one.
+ * The 'aiger_get_block' function stores at most 'size' bytes in 'buffer'
+ * and returns the number of bytes stored, where zero means end-of-file.
+ * The 'aiger_put_block' function returns the number of bytes written,
+ * which is less than 'size' iff writing failed.  See 'aiger_read_blocks'
+ * and 'aiger_write_blocks' below.
+ */
+typedef size_t (*aiger_get_block) (char *buffer, size_t size,
+                                   void *client_state);
+
+typedef size_t (*aiger_put_block) (const char *buffer, size_t size,
+                                   void *client_state);
+
 /*------------------------------------------------------------------------*/
 
 enum aiger_mode
@@ -117,18 +154,19 @@ typedef enum aiger_mode aiger_mode;
 
 struct aiger_and
 {
-  unsigned lhs;			/* as literal [2..2*maxvar], even */
-  unsigned rhs0;		/* as literal [0..2*maxvar+1] */
-  unsigned rhs1;		/* as literal [0..2*maxvar+1] */
+  aiger_lit lhs;		/* as literal [2..2*maxvar], even */
+  aiger_lit rhs0;		/* as literal [0..2*maxvar+1] */
+  aiger_lit rhs1;		/* as literal [0..2*maxvar+1] */
 };
 
 /*------------------------------------------------------------------------*/
 
 struct aiger_symbol
 {
-  unsigned lit;			/* as literal [0..2*maxvar+1] */
-  unsigned next, reset;		/* used only for latches */
-  unsigned size, * lits;	/* used only for justice */
+  aiger_lit lit;		/* as literal [0..2*maxvar+1] */
+  aiger_lit next, reset;	/* used only for latches */
+  unsigned size;		/* used only for justice */
+  aiger_lit * lits;
   char *name;
 };
 
@@ -142,7 +180,7 @@ struct aiger
 {
   /* variable not literal index, e.g. maxlit = 2*maxvar + 1 
    */
-  unsigned maxvar;
+  aiger_lit maxvar;
 
   unsigned num_inputs;
   unsigned num_latches;
@@ -161,11 +199,33 @@ struct aiger
   aiger_symbol *justice;	/* [0..num_justice[ */
   aiger_symbol *fairness;	/* [0..num_fairness[ */
 
-  aiger_and *ands;		/* [0..num_ands[ */
+  aiger_and *ands;		/* [0..num_ands[ unless compact */
 
   char **comments;		/* zero terminated */
+
+  /* In compact mode (see 'aiger_compact') 'ands' is zero and only the
+   * right hand sides are stored.  Read only for the client.
+   */
+  int compact;
+  aiger_lit *rhs0s;		/* [0..num_ands[ if compact */
+  aiger_lit *rhs1s;		/* [0..num_ands[ if compact */
 };
 
+/*------------------------------------------------------------------------*/
+/* Access the AND with index 'i' in '[0..num_ands[' in both modes.  In
+ * compact mode the model is reencoded and the left hand side is implicit.
+ */
+#define aiger_and_lhs(aig,i) \
+  ((aig)->compact ? \
+     2 * ((aiger_lit) (aig)->num_inputs + (aig)->num_latches + (i) + 1) : \
+     (aig)->ands[i].lhs)
+
+#define aiger_and_rhs0(aig,i) \
+  ((aig)->compact ? (aig)->rhs0s[i] : (aig)->ands[i].rhs0)
+
+#define aiger_and_rhs1(aig,i) \
+  ((aig)->compact ? (aig)->rhs1s[i] : (aig)->ands[i].rhs1)
+
 /*------------------------------------------------------------------------*/
 /* Version and CVS identifier.
  */
@@ -186,6 +246,13 @@ aiger *aiger_init (void);
  */
 aiger *aiger_init_mem (void *mem_mgr, aiger_malloc, aiger_free);
 
+/* The same with an additional 'realloc' callback, which allows to grow
+ * arrays in place.  Without it (or if it is zero) arrays are enlarged by
+ * allocating a new one, copying and releasing the old one.
+ */
+aiger *aiger_init_mem_realloc (void *mem_mgr,
+                               aiger_malloc, aiger_realloc, aiger_free);
+
 /*------------------------------------------------------------------------*/
 /* Reset and delete the library.
  */
@@ -199,20 +266,20 @@ void aiger_reset (aiger *);
  * be a latch.  The last argument is the symbolic name if non zero.
  * The same literal can of course be used for multiple outputs.
  */
-void aiger_add_input (aiger *, unsigned lit, const char *);
-void aiger_add_latch (aiger *, unsigned lit, unsigned next, const char *);
-void aiger_add_output (aiger *, unsigned lit, const char *);
-void aiger_add_bad (aiger *, unsigned lit, const char *);
-void aiger_add_constraint (aiger *, unsigned lit, const char *);
-void aiger_add_justice (aiger *, unsigned size, unsigned *, const char *);
-void aiger_add_fairness (aiger *, unsigned lit, const char *);
+void aiger_add_input (aiger *, aiger_lit lit, const char *);
+void aiger_add_latch (aiger *, aiger_lit lit, aiger_lit next, const char *);
+void aiger_add_output (aiger *, aiger_lit lit, const char *);
+void aiger_add_bad (aiger *, aiger_lit lit, const char *);
+void aiger_add_constraint (aiger *, aiger_lit lit, const char *);
+void aiger_add_justice (aiger *, unsigned size, aiger_lit *, const char *);
+void aiger_add_fairness (aiger *, aiger_lit lit, const char *);
 
 /*------------------------------------------------------------------------*/
 /* Add a reset value to the latch 'lit'.  The 'lit' has to be a previously
  * added latch and 'reset' is either '0', '1' or equal to 'lit', the latter
  * means undefined.
  */
-void aiger_add_reset (aiger *, unsigned lit, unsigned reset);
+void aiger_add_reset (aiger *, aiger_lit lit, aiger_lit reset);
 
 /*------------------------------------------------------------------------*/
 /* Register an unsigned AND with AIGER.  The arguments are signed literals
@@ -221,7 +288,37 @@ void aiger_add_reset (aiger *, unsigned lit, unsigned reset);
  * (even).  It identifies the AND and can only be registered once.  After
  * registration an AND can be accessed through 'ands[aiger_lit2idx (lhs)]'.
  */
-void aiger_add_and (aiger *, unsigned lhs, unsigned rhs0, unsigned rhs1);
+void aiger_add_and (aiger *, aiger_lit lhs, aiger_lit rhs0, aiger_lit rhs1);
+
+/*------------------------------------------------------------------------*/
+/* Switch to compact mode, which saves the left hand sides of ANDs and
+ * stores the right hand sides in two separate arrays 'rhs0s' and 'rhs1s'.
+ * Existing ANDs are reencoded first (see 'aiger_reencode').  Afterwards
+ * inputs have to be added before latches and latches before ANDs, always
+ * with the next free variable, and an AND is only allowed to refer to
+ * smaller literals.  The readers fill this layout directly from binary
+ * files and reencode ASCII files.  Access ANDs only through the accessor
+ * macros above.  The 'aiger_is_and' function returns a temporary copy of
+ * the AND, which is valid until the next call.
+ */
+void aiger_compact (aiger *);
+
+/*------------------------------------------------------------------------*/
+/* Reserve space for the given number of variables, inputs, latches etc.
+ * before adding them, so that each array is allocated only once.  This is
+ * only a hint and does not change the model.  The readers use the numbers
+ * in the header.
+ */
+void aiger_reserve (aiger *,
+                    aiger_lit maxvar,
+                    unsigned inputs,
+                    unsigned latches,
+                    unsigned outputs,
+                    unsigned ands,
+                    unsigned bad,
+                    unsigned constraints,
+                    unsigned justice,
+                    unsigned fairness);
 
 /*------------------------------------------------------------------------*/
 /* Add a line of comments.  The comment may not contain a new line character.
@@ -235,7 +332,9 @@ void aiger_add_comment (aiger *, const char *comment_line);
  * means that the corresponding literal is a constant 0 or 1, or defined as
  * an input, a latch, or AND gate.  Furthermore the definitions of ANDs are
  * checked to be non cyclic.  If a check fails a corresponding error message
- * is returned.
+ * is returned.  Successful checks are cached until the model changes (see
+ * 'aiger_changed').  If all right hand sides of ANDs are smaller than their
+ * left hand side, cycles are excluded in linear time without search.
  */
 const char *aiger_check (aiger *);
 
@@ -251,13 +350,84 @@ int aiger_write_to_file (aiger *, aiger_mode, FILE *);
 int aiger_write_to_string (aiger *, aiger_mode, char *str, size_t len);
 int aiger_write_generic (aiger *, aiger_mode, void *state, aiger_put);
 
+/*------------------------------------------------------------------------*/
+/* Same as 'aiger_write_generic' except that the output is collected in an
+ * internal buffer and handed over to the client in blocks of bytes instead
+ * of calling 'aiger_put' for every single character.  This is also the
+ * basis of 'aiger_write_to_file' and 'aiger_write_to_string'.
+ */
+int aiger_write_blocks (aiger *, aiger_mode, void *state, aiger_put_block);
+
+/*------------------------------------------------------------------------*/
+/* Exact number of bytes written in the given mode (without the terminating
+ * zero byte of 'aiger_write_to_string').  It is computed in one pass over
+ * the model without encoding it, but binary mode reencodes the model as the
+ * writers do.  Returns zero on failure.
+ */
+size_t aiger_binary_size (aiger *, aiger_mode);
+
+/* Write the model into a new buffer of exactly 'aiger_binary_size' bytes
+ * plus a terminating zero byte, which is allocated once through the memory
+ * manager of the model.  The size without zero byte is stored in
+ * '*size_ptr'.  The buffer has to be released with the 'aiger_free'
+ * function of the memory manager and size '*size_ptr + 1', i.e., with
+ * 'free' if 'aiger_init' was used.  Returns zero on failure.
+ */
+char *aiger_write_to_new_buffer (aiger *, aiger_mode, size_t * size_ptr);
+
+/*------------------------------------------------------------------------*/
+/* Streaming writer for the binary format, which writes a model piece by
+ * piece without storing it, e.g., while it is generated.  The header (see
+ * 'aiger_read_header_only' below) has to be known in advance and fulfill
+ * 'maxvar == inputs + latches + ands'.  The 'aiger' argument only provides
+ * the memory manager.  Inputs are implicit.  Then the latches, outputs,
+ * bad, constraints, justice and fairness properties and ANDs have to be
+ * pushed in this order and exactly as many as given in the header,
+ * followed by optional symbols and comments.  The left hand side of an
+ * AND is determined by the writer and returned by 'aiger_stream_and'.  Its
+ * right hand sides have to be smaller.  Justice properties are buffered
+ * until the next section is started, since the sizes of all of them are
+ * written before their literals.  The push functions and
+ * 'aiger_delete_stream_writer', which has to be called in any case, return
+ * zero on write errors and if more or fewer entries of a section than
+ * given in the header were pushed, since the written file would not match
+ * its header.  After that all further pushes fail.
+ */
+typedef struct aiger_stream_writer aiger_stream_writer;
+
+aiger_stream_writer *aiger_new_stream_writer (aiger *,
+                                              const aiger_header *,
+                                              void *state, aiger_put_block);
+aiger_stream_writer *aiger_new_stream_writer_to_file (aiger *,
+                                                      const aiger_header *,
+                                                      FILE *);
+
+int aiger_stream_latch (aiger_stream_writer *,
+                        aiger_lit next, aiger_lit reset);
+int aiger_stream_output (aiger_stream_writer *, aiger_lit lit);
+int aiger_stream_bad (aiger_stream_writer *, aiger_lit lit);
+int aiger_stream_constraint (aiger_stream_writer *, aiger_lit lit);
+int aiger_stream_justice (aiger_stream_writer *,
+                          unsigned size, const aiger_lit *lits);
+int aiger_stream_fairness (aiger_stream_writer *, aiger_lit lit);
+aiger_lit aiger_stream_and (aiger_stream_writer *,
+                            aiger_lit rhs0, aiger_lit rhs1);
+int aiger_stream_symbol (aiger_stream_writer *,
+                         char type, unsigned pos, const char *name);
+int aiger_stream_comment (aiger_stream_writer *, const char *);
+
+int aiger_delete_stream_writer (aiger_stream_writer *);
+
 /*------------------------------------------------------------------------*/
 /* The following function allows to write to a file.  The write mode is
  * determined from the suffix in the file name.  The mode used is ASCII for
- * a '.aag' suffix and binary mode otherwise.  In addition a '.gz' suffix can
- * be added which requests the file to written by piping it through 'gzip'.
- * This feature assumes that the 'gzip' program is in your path and can be
- * executed through 'popen'.  The return value is non zero on success.
+ * a '.aag' suffix and binary mode otherwise.  In addition a '.gz', '.xz' or
+ * '.zst' suffix can be added which requests the file to be compressed.  If
+ * the library was compiled with 'zlib', 'liblzma' or 'libzstd' support
+ * (see 'configure.sh') this happens in-process.  Otherwise the file is
+ * piped through 'gzip', 'xz' or 'zstd', which assumes that the program is
+ * in your path and can be executed through 'popen'.  The return value is
+ * non zero on success.
  */
 int aiger_open_and_write_to_file (aiger *, const char *file_name);
 
@@ -278,15 +448,54 @@ void aiger_reencode (aiger *);
 
 /*------------------------------------------------------------------------*/
 /* This function computes the cone of influence (coi). The coi contains
- * those literals that may have an influence to one of the outputs.   A
- * variable 'v' is in the coi if the array returned as result is non zero at
- * position 'v'. All other variables can be considered redundant.  The array
- * returned is valid until the next call to this function and will be
- * deallocated on reset.
- *
- * TODO: this is just a stub and actually not really implemented yet.
+ * those variables that may have an influence to one of the outputs, bad
+ * state properties, invariant constraints, justice or fairness properties
+ * through ANDs, next state functions and resets of latches.   A variable
+ * 'v' is in the coi if the array returned as result is non zero at position
+ * 'v'. All other variables can be considered redundant.  The array returned
+ * is valid until the next call to one of the two coi functions and will be
+ * deallocated on reset.  It is computed in linear time and cached until the
+ * model changes.  The second version computes the coi of the given
+ * literals only, e.g., of a single property.
  */
 const unsigned char * aiger_coi (aiger *);		/* [1..maxvar] */
+const unsigned char * aiger_coi_of_lits (aiger *,
+                                         const aiger_lit * lits,
+                                         unsigned num_lits);
+
+/* All library functions which change the model invalidate cached results
+ * such as the coi or a successful 'aiger_check'.  Clients which modify the
+ * public arrays directly have to call this function afterwards.
+ */
+void aiger_changed (aiger *);
+
+/*------------------------------------------------------------------------*/
+/* Fanout index of the ANDs in compressed sparse row format.  The fanouts
+ * of variable 'v' are 'targets[offsets[v]]' up to (excluding)
+ * 'targets[offsets[v+1]]' in the order of the ANDs.  A target is the left
+ * hand side of an AND using 'v', with the sign bit set if that AND uses
+ * the negation of 'v'.  The level of inputs, latches and the constant is
+ * zero and of an AND one more than the maximum level of its inputs.  The
+ * reverse level is zero for variables without fanout and otherwise one
+ * more than the maximum reverse level of the fanouts.  All arrays have
+ * 'size = maxvar + 1' entries, except 'offsets' which has 'size + 1'.
+ */
+typedef struct aiger_fanouts aiger_fanouts;
+
+struct aiger_fanouts
+{
+  aiger_lit size;
+  aiger_lit *offsets;
+  aiger_lit *targets;
+  unsigned *levels;
+  unsigned *reverse_levels;
+};
+
+/* Build the fanout index of a checked model in linear time.  It is cached
+ * until the model changes (see 'aiger_changed') and then deallocated on
+ * the next call or on reset.  The result should not be modified.
+ */
+const aiger_fanouts *aiger_get_fanouts (aiger *);
 
 /*------------------------------------------------------------------------*/
 /* Read an AIG from a FILE, a string, or through a generic interface.  These
@@ -300,6 +509,109 @@ const char *aiger_read_from_file (aiger *, FILE *);
 const char *aiger_read_from_string (aiger *, const char *str);
 const char *aiger_read_generic (aiger *, void *state, aiger_get);
 
+/*------------------------------------------------------------------------*/
+/* Same as 'aiger_read_generic' but reads blocks of bytes through the
+ * 'aiger_get_block' call-back (see above) into an internal buffer.  This is
+ * also used by 'aiger_read_from_file' and 'aiger_read_from_string'.  As all
+ * other readers, it consumes the input until 'EOF'.
+ */
+const char *aiger_read_blocks (aiger *, void *state, aiger_get_block);
+
+/*------------------------------------------------------------------------*/
+/* Same as 'aiger_read_from_file' except that the AND section of binary
+ * files is decoded by 'threads' threads.  The input is mapped into memory
+ * if it is a regular file and otherwise read completely into a buffer
+ * first.  If the library was compiled without 'pthread' support (see
+ * 'configure.sh') or the model is small, a single thread is used.
+ */
+const char *aiger_read_parallel (aiger *, FILE *, unsigned threads);
+
+/*------------------------------------------------------------------------*/
+/* Only parse the header line 'M I L O A B C J F' of the file and store it
+ * in 'header'.  The model itself is not changed.  Since nothing after the
+ * header is read, this is very fast even for huge (compressed) files.
+ */
+struct aiger_header
+{
+  aiger_mode mode;
+  aiger_lit maxvar;
+  unsigned inputs;
+  unsigned latches;
+  unsigned outputs;
+  unsigned ands;
+  unsigned bad;
+  unsigned constraints;
+  unsigned justice;
+  unsigned fairness;
+};
+
+const char *aiger_read_header_only (aiger *, const char *file_name,
+                                    aiger_header *);
+
+/*------------------------------------------------------------------------*/
+/* After calling this function all read functions skip the AND section
+ * without storing or checking ANDs, e.g., for tools which only need the
+ * symbol table or the comments.  The resulting model is incomplete and
+ * should not be used for anything else.  In particular 'aiger_check' is
+ * not called while reading.
+ */
+void aiger_skip_ands (aiger *);
+
+/*------------------------------------------------------------------------*/
+/* Streaming interface.  After 'aiger_set_visitor' all read functions pass
+ * every part of the model to the corresponding call-back of the visitor in
+ * the order of the file instead of storing it.  Call-backs which are zero
+ * are skipped.  Thus memory usage does not depend on the number of ANDs
+ * (except for the parallel reader, which then falls back to one thread).
+ * Only syntax and literal ranges are checked, since 'aiger_check' needs
+ * the whole model.  The model itself stays empty except for 'maxvar'.
+ * The 'type' of a symbol is one of 'i', 'l', 'o', 'b', 'c', 'j' or 'f'
+ * and 'pos' its position in the corresponding section.  Names, comments
+ * and justice literals are only valid during the call-back.  Calling
+ * 'aiger_set_visitor' with zero switches back to storing models.
+ */
+typedef struct aiger_visitor aiger_visitor;
+
+struct aiger_visitor
+{
+  void *state;
+  void (*header) (void *state, const aiger_header *);
+  void (*input) (void *state, aiger_lit lit);
+  void (*latch) (void *state, aiger_lit lit, aiger_lit next, aiger_lit reset);
+  void (*output) (void *state, aiger_lit lit);
+  void (*bad) (void *state, aiger_lit lit);
+  void (*constraint) (void *state, aiger_lit lit);
+  void (*justice) (void *state, unsigned size, const aiger_lit *lits);
+  void (*fairness) (void *state, aiger_lit lit);
+  void (*and_gate) (void *state,
+                    aiger_lit lhs, aiger_lit rhs0, aiger_lit rhs1);
+  void (*symbol) (void *state, char type, unsigned pos, const char *name);
+  void (*comment) (void *state, const char *comment);
+};
+
+void aiger_set_visitor (aiger *, const aiger_visitor *);
+
+/*------------------------------------------------------------------------*/
+/* The symbol table and comments are copied as one block while reading and
+ * names and comments point into this block.  After 'aiger_lazy_symbols'
+ * the block is only parsed on demand, i.e., by 'aiger_get_symbol', the
+ * writers, stripping, adding comments or explicitly by calling
+ * 'aiger_load_symbols'.  The latter is necessary before accessing names
+ * or comments directly.  Errors in the symbol table are then also only
+ * reported by 'aiger_load_symbols' (or the functions calling it).
+ */
+void aiger_lazy_symbols (aiger *);
+const char *aiger_load_symbols (aiger *);
+
+/*------------------------------------------------------------------------*/
+/* Let all block oriented writers, e.g., 'aiger_write_to_file',
+ * 'aiger_write_blocks' and 'aiger_open_and_write_to_file', encode the AND
+ * section of binary files with 'threads' threads.  The result is the same
+ * as with one thread.  If the library was compiled without 'pthread'
+ * support (see 'configure.sh') or the model is small, one thread is used.
+ */
+void aiger_write_threads (aiger *, unsigned threads);
+
 /*------------------------------------------------------------------------*/
 /* Returns a previously generated error message if the library is in an
  * invalid state.  After this function returns a non zero error message,
@@ -311,6 +623,9 @@ const char *aiger_error (aiger const *);
 
 /*------------------------------------------------------------------------*/
 /* Same semantics as with 'aiger_open_and_write_to_file' for reading.
+ * Uncompressed regular files are mapped into memory and parsed directly
+ * from the mapped pages.  Pipes, devices and compressed files are read
+ * through 'stdio' as before.
  */
 const char *aiger_open_and_read_from_file (aiger *, const char *);
 
@@ -335,7 +650,19 @@ unsigned aiger_strip_comments (aiger *);
  * Names for outputs are stored in the 'outputs' symbols and can only be
  * accesed through a linear traversal of the output symbols.
  */
-const char *aiger_get_symbol (aiger const *, unsigned lit);
+const char *aiger_get_symbol (aiger const *, aiger_lit lit);
+
+/*------------------------------------------------------------------------*/
+/* Reverse lookup of symbols by name through a hash table, which is built
+ * on the first call in linear time and kept until the model changes.  If
+ * 'tag' is non zero the type of the symbol as in the symbol table, i.e.,
+ * one of the characters 'i', 'l', 'o', 'b', 'c', 'j' or 'f', is stored
+ * there.  The position of the symbol is obtained by subtracting the start
+ * of the corresponding array, e.g., 'public->inputs'.  If several symbols
+ * have the same name, the first in symbol table order is returned.  The
+ * result is zero if there is no symbol with this name.
+ */
+aiger_symbol *aiger_find_symbol (aiger *, const char *name, int *tag);
 
 /*------------------------------------------------------------------------*/
 /* Return tag of the literal:
@@ -346,7 +673,7 @@ const char *aiger_get_symbol (aiger const *, unsigned lit);
  * 3 = and
  */
 
-int aiger_lit2tag (aiger const *, unsigned lit);
+int aiger_lit2tag (aiger const *, aiger_lit lit);
 
 /*------------------------------------------------------------------------*/
 /* Check whether the given unsigned, e.g. even, literal was defined as
@@ -359,9 +686,9 @@ int aiger_lit2tag (aiger const *, unsigned lit);
  * For outputs this is not possible, since the same literal may be used for
  * several outputs.
  */
-aiger_symbol *aiger_is_input (aiger const *, unsigned lit);
-aiger_symbol *aiger_is_latch (aiger const *, unsigned lit);
-aiger_and *aiger_is_and (aiger const *, unsigned lit);
+aiger_symbol *aiger_is_input (aiger const *, aiger_lit lit);
+aiger_symbol *aiger_is_latch (aiger const *, aiger_lit lit);
+aiger_and *aiger_is_and (aiger const *, aiger_lit lit);
 
 #ifdef __cplusplus
 }
@@ -51,6 +51,7 @@ main (int argc, char **argv)
     }
 
   aiger = aiger_init ();
+  aiger_skip_ands (aiger);	/* not needed */
 
   if (file_name)
     error = aiger_open_and_read_from_file (aiger, file_name);
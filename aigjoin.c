@@ -23,6 +23,7 @@ IN THE SOFTWARE.
 #include "aiger.h"
 
 #include <assert.h>
+#include <ctype.h>
 #include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
@@ -32,7 +33,7 @@ IN THE SOFTWARE.
 typedef struct AIG AIG;
 
 #define USAGE \
-"usage: aigjoin [-h][-v][-f][-o <output>][<input> ...]\n" \
+"usage: aigjoin [-h][-v][-f][-j <threads>][-o <output>][<input> ...]\n" \
 "\n" \
 "Join AIGER models.\n"
 
@@ -358,6 +359,7 @@ main (int argc, char ** argv)
   const char * output = 0, * err;
   AIG * a, * n, * r0, * r1, * l;
   int i, force = 0, ok;
+  unsigned threads = 1;
   aiger ** q, * src;
   aiger_mode mode;
   aiger_and * b;
@@ -376,6 +378,16 @@ main (int argc, char ** argv)
 	verbose++;
       else if (!strcmp (argv[i], "-f"))
 	force = 1;
+      else if (!strcmp (argv[i], "-j"))
+	{
+	  if (++i == argc)
+	    die ("argument to '-j' missing");
+
+	  for (const char * d = argv[i]; *d; d++)
+	    if (!isdigit (*d))
+	      die ("invalid command line option '-j %s'", argv[i]);
+	  threads = (unsigned) atoi (argv[i]);
+	}
       else if (!strcmp (argv[i], "-o"))
 	{
 	  if (++i == argc)
@@ -590,6 +602,8 @@ main (int argc, char ** argv)
 
   msg (1, "writing %s", output ? output : "<stdout>");
 
+  aiger_write_threads (dst, threads);
+
   if (output)
     ok = aiger_open_and_write_to_file (dst, output);
   else
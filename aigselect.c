@@ -120,18 +120,6 @@ do { \
   STACK[size_ ## STACK ++] = ELEMENT; \
 } while (0)
 
-#define COI(LIT) \
-do { \
-  unsigned VAR; \
-  if (aiger_is_constant (LIT)) \
-    break; \
-  VAR = aiger_lit2var (LIT); \
-  if (coi[VAR]) \
-    break; \
-  coi[VAR] = 1; \
-  PUSH (stack, VAR); \
-} while (0)
-
 #define KEEP(LIT) \
   (aiger_is_constant (LIT) || coi[aiger_lit2var (LIT)])
 
@@ -158,7 +146,7 @@ main (int argc, char ** argv)
   unsigned mapped;
   unsigned * map;
   aiger_and * a;
-  char * coi;
+  const unsigned char * coi;
   int reduce;
   size_t i;
   int ok;
@@ -228,10 +216,6 @@ main (int argc, char ** argv)
   if (!src->num_outputs)
     die ("can not find any outputs in '%s'", input);
 
-  coi = calloc (src->maxvar + 1, 1);
-  if (!coi)
-    die ("out-of-memory allocating 'coi'");
-
   for (i = 0; i != size_selected; i++)
     {
       unsigned selection, lit;
@@ -242,35 +226,15 @@ main (int argc, char ** argv)
 	     selection, src->num_outputs-1);
 
       lit = src->outputs[selection].lit;
-      COI (lit);
+      PUSH (stack, lit);
     }
 
-  for (i = 0; i != size_stack; i++)
-    {
-      unsigned var, lit;
-      aiger_symbol * s;
-      aiger_and * a;
-
-      var = stack[i];
-      assert (coi[var]);
-      lit = aiger_var2lit (var);
+  coi = aiger_coi_of_lits (src, stack, size_stack);
 
-      a = aiger_is_and (src, lit);
-      if (a)
-	{
-	  COI (a->rhs0);
-	  COI (a->rhs1);
-	}
-      else
-	{
-	  s = aiger_is_latch (src, lit);
-	  if (s)
-	    {
-	      COI (s->next);
-	      COI (s->reset);
-	    }
-	}
-    }
+  size_stack = 0;
+  for (j = 1; j <= src->maxvar; j++)
+    if (coi[j])
+      size_stack++;
 
   msg ("found %zu literals in cone-of-influence", size_stack);
 
@@ -378,7 +342,7 @@ main (int argc, char ** argv)
 
   aiger_reset (dst);
   free (selected);
-  free (coi);
+  free (stack);
   free (map);
 
   return 0;
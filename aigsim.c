@@ -26,8 +26,27 @@ IN THE SOFTWARE.
 #include <string.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <assert.h>
 #include <ctype.h>
+#include <sys/time.h>
+
+#ifdef AIGER_HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#ifdef AIGER_HAVE_DLOPEN
+#include <dlfcn.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define AIGSIM_X86_KERNELS
+#include <immintrin.h>
+#endif
 
 static FILE *file;
 static int close_file;
@@ -147,6 +166,976 @@ IGNORE_REST_OF_LINE:
   return start;
 }
 
+/*------------------------------------------------------------------------*/
+/* Bit-parallel random simulation ('-p <runs>').  Every variable has one
+ * 64-bit word per 64 independent runs, where bit 'b' of word 'w' is its
+ * value in run '64 * w + b'.  Random inputs and the initial values of
+ * uninitialized latches are hashed from the seed, the step, the position
+ * and the word.  Thus the trace of any run can be reproduced afterwards
+ * to print a witness.  The words are partitioned among workers ('-j'),
+ * which simulate their runs independently of each other.
+ */
+static unsigned words;		/* words per variable with runs */
+static unsigned num_runs;
+static unsigned num_steps;
+static uint64_t seed_state;
+static unsigned first_and;	/* variable of first AND */
+static unsigned *rhs0s, *rhs1s;	/* right hand sides of ANDs */
+
+/* First hit of each bad state property as step plus one and run.  Shared
+ * by all workers and only accessed with 'hits_mutex' locked.
+ */
+static unsigned *hit_steps, *hit_runs;
+
+#ifdef AIGER_HAVE_PTHREAD
+static pthread_mutex_t hits_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+typedef struct worker worker;
+
+struct worker
+{
+  unsigned begin, end;		/* words [begin..end[ of all runs */
+  unsigned stride;		/* allocated words per variable */
+  uint64_t *values;
+  uint64_t *next_values;
+  uint64_t *alive;		/* runs without constraint violation */
+  unsigned simulated;		/* steps */
+#ifdef AIGER_HAVE_PTHREAD
+  pthread_t thread;
+#endif
+};
+
+static uint64_t
+mix64 (uint64_t z)
+{
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+/* Word 'w' of input 'pos' at 'step' or of latch 'pos - num_inputs' at step
+ * zero, which is element 'counter' of a 'splitmix64' sequence.
+ */
+static uint64_t
+random_word (unsigned step, unsigned pos, unsigned w)
+{
+  uint64_t counter = step;
+  counter = counter * (model->num_inputs + model->num_latches) + pos;
+  counter = counter * words + w;
+  return mix64 (seed_state + (counter + 1) * 0x9e3779b97f4a7c15ull);
+}
+
+static uint64_t *
+lit2words (worker * worker, unsigned lit)
+{
+  return worker->values + (size_t) aiger_lit2var (lit) * worker->stride;
+}
+
+static uint64_t
+word_of_lit (worker * worker, unsigned lit, unsigned w)
+{
+  return lit2words (worker, lit)[w] ^ -(uint64_t) aiger_sign (lit);
+}
+
+/* The kernels evaluate all ANDs on 'stride' words per variable.  After
+ * reencoding the left hand side of AND 'i' is variable 'first_and + i'.
+ */
+static void
+simulate_ands_word (worker * worker)
+{
+  uint64_t ma, mb, *c, *values = worker->values;
+  unsigned i, w, stride = worker->stride;
+  const uint64_t *a, *b;
+
+  c = values + (size_t) first_and * stride;
+
+  if (stride == 1)
+    {
+      for (i = 0; i < model->num_ands; i++)
+	c[i] = (values[rhs0s[i] / 2] ^ -(uint64_t) aiger_sign (rhs0s[i])) &
+	  (values[rhs1s[i] / 2] ^ -(uint64_t) aiger_sign (rhs1s[i]));
+      return;
+    }
+
+  for (i = 0; i < model->num_ands; i++, c += stride)
+    {
+      a = lit2words (worker, rhs0s[i]);
+      b = lit2words (worker, rhs1s[i]);
+      ma = -(uint64_t) aiger_sign (rhs0s[i]);
+      mb = -(uint64_t) aiger_sign (rhs1s[i]);
+      for (w = 0; w < stride; w++)
+	c[w] = (a[w] ^ ma) & (b[w] ^ mb);
+    }
+}
+
+#ifdef AIGSIM_X86_KERNELS
+
+__attribute__ ((target ("avx2")))
+static void
+simulate_ands_avx2 (worker * worker)
+{
+  unsigned i, w, stride = worker->stride;
+  const uint64_t *a, *b;
+  __m256i ma, mb, x, y;
+  uint64_t *c;
+
+  c = worker->values + (size_t) first_and * stride;
+  for (i = 0; i < model->num_ands; i++, c += stride)
+    {
+      a = lit2words (worker, rhs0s[i]);
+      b = lit2words (worker, rhs1s[i]);
+      ma = _mm256_set1_epi64x (-(long long) aiger_sign (rhs0s[i]));
+      mb = _mm256_set1_epi64x (-(long long) aiger_sign (rhs1s[i]));
+      for (w = 0; w < stride; w += 4)
+	{
+	  x = _mm256_loadu_si256 ((const __m256i *) (a + w));
+	  y = _mm256_loadu_si256 ((const __m256i *) (b + w));
+	  x = _mm256_xor_si256 (x, ma);
+	  y = _mm256_xor_si256 (y, mb);
+	  _mm256_storeu_si256 ((__m256i *) (c + w), _mm256_and_si256 (x, y));
+	}
+    }
+}
+
+__attribute__ ((target ("avx512f")))
+static void
+simulate_ands_avx512 (worker * worker)
+{
+  unsigned i, w, stride = worker->stride;
+  const uint64_t *a, *b;
+  __m512i ma, mb, x, y;
+  uint64_t *c;
+
+  c = worker->values + (size_t) first_and * stride;
+  for (i = 0; i < model->num_ands; i++, c += stride)
+    {
+      a = lit2words (worker, rhs0s[i]);
+      b = lit2words (worker, rhs1s[i]);
+      ma = _mm512_set1_epi64 (-(long long) aiger_sign (rhs0s[i]));
+      mb = _mm512_set1_epi64 (-(long long) aiger_sign (rhs1s[i]));
+      for (w = 0; w < stride; w += 8)
+	{
+	  x = _mm512_xor_si512 (_mm512_loadu_si512 (a + w), ma);
+	  y = _mm512_xor_si512 (_mm512_loadu_si512 (b + w), mb);
+	  _mm512_storeu_si512 (c + w, _mm512_and_si512 (x, y));
+	}
+    }
+}
+
+#endif
+
+typedef struct kernel kernel;
+
+struct kernel
+{
+  const char *name;
+  unsigned words;		/* handled at once */
+  void (*simulate) (worker *);
+};
+
+/* Ordered by width, since the widest supported kernel is the default.
+ */
+static const kernel kernels[] = {
+  {"word", 1, simulate_ands_word},
+#ifdef AIGSIM_X86_KERNELS
+  {"avx2", 4, simulate_ands_avx2},
+  {"avx512", 8, simulate_ands_avx512},
+#endif
+};
+
+#define NUM_KERNELS (sizeof kernels / sizeof kernels[0])
+
+static const kernel *simulation_kernel;
+
+static int
+kernel_supported (const kernel * k)
+{
+#ifdef AIGSIM_X86_KERNELS
+  __builtin_cpu_init ();
+  if (k->simulate == simulate_ands_avx2)
+    return __builtin_cpu_supports ("avx2");
+  if (k->simulate == simulate_ands_avx512)
+    return __builtin_cpu_supports ("avx512f");
+#endif
+  (void) k;
+  return 1;
+}
+
+/* Without a name the widest supported kernel not wider than 'max_words'
+ * is selected.
+ */
+static const kernel *
+select_kernel (const char *name, unsigned max_words)
+{
+  const kernel *k, *res = 0;
+
+  for (k = kernels; k < kernels + NUM_KERNELS; k++)
+    {
+      if (!name)
+	{
+	  if (k->words <= max_words && kernel_supported (k))
+	    res = k;
+	}
+      else if (!strcmp (name, k->name))
+	{
+	  if (!kernel_supported (k))
+	    die ("kernel '%s' not supported on this machine", name);
+	  return k;
+	}
+    }
+
+  if (name)
+    die ("unknown kernel '%s' (try '-h')", name);
+
+  assert (res);
+  return res;
+}
+
+static double
+wall_clock_time (void)
+{
+  struct timeval tv;
+  gettimeofday (&tv, 0);
+  return tv.tv_sec + 1e-6 * tv.tv_usec;
+}
+
+static void
+lock_hits (void)
+{
+#ifdef AIGER_HAVE_PTHREAD
+  pthread_mutex_lock (&hits_mutex);
+#endif
+}
+
+static void
+unlock_hits (void)
+{
+#ifdef AIGER_HAVE_PTHREAD
+  pthread_mutex_unlock (&hits_mutex);
+#endif
+}
+
+/* Mark the properties for which a hit at 'step' could still be earlier
+ * than the hits found so far.  Hits at the same step may still come from
+ * runs with smaller numbers in other workers.  Returns zero if there are
+ * none, which cancels the worker.
+ */
+static int
+open_properties (unsigned step, unsigned char *open)
+{
+  unsigned j;
+  int res = 0;
+
+  lock_hits ();
+  for (j = 0; j < model->num_bad; j++)
+    res |= open[j] = !hit_steps[j] || hit_steps[j] > step;
+  unlock_hits ();
+
+  return res;
+}
+
+static void
+hit (unsigned bad, unsigned step, unsigned run)
+{
+  lock_hits ();
+  if (!hit_steps[bad] || step + 1 < hit_steps[bad] ||
+      (step + 1 == hit_steps[bad] && run < hit_runs[bad]))
+    {
+      hit_steps[bad] = step + 1;
+      hit_runs[bad] = run;
+    }
+  unlock_hits ();
+}
+
+static void *
+simulate_worker (void *ptr)
+{
+  unsigned i, j, w, n, step;
+  worker *worker = ptr;
+  aiger_symbol *symbol;
+  unsigned char *open;
+  uint64_t *v, hits;
+  int some_alive;
+
+  n = worker->end - worker->begin;
+  worker->values = calloc ((size_t) (model->maxvar + 1) * worker->stride,
+			   sizeof *worker->values);
+  worker->next_values = calloc ((size_t) model->num_latches * n,
+				sizeof *worker->next_values);
+  worker->alive = malloc (n * sizeof *worker->alive);
+  open = malloc (model->num_bad + 1);
+
+  if (!worker->values || !worker->next_values || !worker->alive || !open)
+    die ("out of memory");
+
+  for (w = 0; w < n; w++)
+    worker->alive[w] = ~(uint64_t) 0;
+  if (worker->end == words && num_runs % 64)
+    worker->alive[n - 1] >>= 64 - num_runs % 64;
+
+  for (i = 0; i < model->num_latches; i++)
+    {
+      symbol = model->latches + i;
+      v = lit2words (worker, symbol->lit);
+      for (w = 0; w < n; w++)
+	if (symbol->reset <= 1)
+	  v[w] = -(uint64_t) symbol->reset;
+	else
+	  v[w] = random_word (0, model->num_inputs + i, worker->begin + w);
+    }
+
+  for (step = 0; step < num_steps && open_properties (step, open); step++)
+    {
+      for (i = 0; i < model->num_inputs; i++)
+	{
+	  v = lit2words (worker, model->inputs[i].lit);
+	  for (w = 0; w < n; w++)
+	    v[w] = random_word (step, i, worker->begin + w);
+	}
+
+      simulation_kernel->simulate (worker);
+      worker->simulated++;
+
+      /* Runs violating a constraint are dead from now on.
+       */
+      some_alive = 0;
+      for (w = 0; w < n; w++)
+	{
+	  for (j = 0; j < model->num_constraints; j++)
+	    worker->alive[w] &=
+	      word_of_lit (worker, model->constraints[j].lit, w);
+	  some_alive |= !!worker->alive[w];
+	}
+      if (!some_alive)
+	break;
+
+      for (j = 0; j < model->num_bad; j++)
+	{
+	  if (!open[j])
+	    continue;
+
+	  for (w = 0; w < n; w++)
+	    if ((hits = word_of_lit (worker, model->bad[j].lit, w) &
+		 worker->alive[w]))
+	      break;
+
+	  if (w == n)
+	    continue;
+
+	  for (i = 0; !(hits & 1); i++)
+	    hits >>= 1;
+
+	  hit (j, step, 64 * (worker->begin + w) + i);
+	}
+
+      for (i = 0; i < model->num_latches; i++)
+	{
+	  v = worker->next_values + (size_t) i * n;
+	  for (w = 0; w < n; w++)
+	    v[w] = word_of_lit (worker, model->latches[i].next, w);
+	}
+
+      for (i = 0; i < model->num_latches; i++)
+	memcpy (lit2words (worker, model->latches[i].lit),
+		worker->next_values + (size_t) i * n,
+		n * sizeof *worker->values);
+    }
+
+  free (open);
+  free (worker->alive);
+  free (worker->next_values);
+  free (worker->values);
+
+  return 0;
+}
+
+static int
+random_bit (unsigned step, unsigned pos, unsigned run)
+{
+  return (random_word (step, pos, run / 64) >> (run % 64)) & 1;
+}
+
+/* Print the witness of 'run' hitting bad state property 'bad' after
+ * 'steps' steps in the format checked by 'aigsim -c'.
+ */
+static void
+print_parallel_witness (unsigned bad, unsigned run, unsigned steps)
+{
+  unsigned i, j;
+
+  printf ("c b%u first hit by run %u at step %u\n", bad, run, steps - 1);
+  printf ("1\nb%u\n", bad);
+
+  for (i = 0; i < model->num_latches; i++)
+    {
+      unsigned reset = model->latches[i].reset;
+      if (reset > 1)
+	reset = random_bit (0, model->num_inputs + i, run);
+      fputc ('0' + reset, stdout);
+    }
+  fputc ('\n', stdout);
+
+  for (j = 0; j < steps; j++)
+    {
+      for (i = 0; i < model->num_inputs; i++)
+	fputc ('0' + random_bit (j, i, run), stdout);
+      fputc ('\n', stdout);
+    }
+
+  printf (".\n");
+}
+
+/* Witnesses do not depend on the kernel nor the number of threads, since
+ * workers only stop early if they can not find earlier hits anymore.
+ */
+static void
+simulate_parallel (unsigned runs, unsigned steps, unsigned seed,
+		   const char *kernel_name, unsigned threads)
+{
+  const kernel *kernel;
+  aiger_symbol *symbol;
+  worker *workers, *w;
+  double start, evals;
+  unsigned i, n;
+
+  for (i = 0; i < model->num_latches; i++)
+    {
+      symbol = model->latches + i;
+      if (symbol->reset > 1 && symbol->reset != symbol->lit)
+	die ("latch %u has unsupported reset function %u",
+	     symbol->lit, symbol->reset);
+    }
+
+  num_runs = runs;
+  num_steps = steps;
+  words = (runs + 63) / 64;
+  seed_state = mix64 (seed);
+  if (threads > words)
+    threads = words;
+  kernel = simulation_kernel = select_kernel (kernel_name, words / threads);
+
+  rhs0s = malloc (model->num_ands * sizeof *rhs0s);
+  rhs1s = malloc (model->num_ands * sizeof *rhs1s);
+  hit_steps = calloc (model->num_bad, sizeof *hit_steps);
+  hit_runs = calloc (model->num_bad, sizeof *hit_runs);
+  workers = calloc (threads, sizeof *workers);
+
+  if (!workers ||
+      (model->num_bad && (!hit_steps || !hit_runs)) ||
+      (model->num_ands && (!rhs0s || !rhs1s)))
+    die ("out of memory");
+
+  first_and = model->num_inputs + model->num_latches + 1;
+  for (i = 0; i < model->num_ands; i++)
+    {
+      assert (model->ands[i].lhs == 2 * (first_and + i));
+      rhs0s[i] = model->ands[i].rhs0;
+      rhs1s[i] = model->ands[i].rhs1;
+    }
+
+  for (i = 0; i < threads; i++)
+    {
+      w = workers + i;
+      w->begin = (unsigned) ((uint64_t) words * i / threads);
+      w->end = (unsigned) ((uint64_t) words * (i + 1) / threads);
+      n = w->end - w->begin;
+      w->stride = (n + kernel->words - 1) / kernel->words * kernel->words;
+    }
+
+  start = wall_clock_time ();
+
+#ifdef AIGER_HAVE_PTHREAD
+  for (i = 1; i < threads; i++)
+    if (pthread_create (&workers[i].thread, 0, simulate_worker, workers + i))
+      die ("failed to create thread");
+  simulate_worker (workers);
+  for (i = 1; i < threads; i++)
+    pthread_join (workers[i].thread, 0);
+#else
+  for (i = 0; i < threads; i++)
+    simulate_worker (workers + i);
+#endif
+
+  evals = 0;
+  for (i = 0; i < threads; i++)
+    {
+      w = workers + i;
+      n = (w->end == words) ? runs - 64 * w->begin : 64 * (w->end - w->begin);
+      evals += (double) model->num_ands * n * w->simulated;
+    }
+
+  fprintf (stderr,
+	   "[aigsim] %u runs of up to %u steps with %u threads and '%s' "
+	   "kernel: %.3g gate evaluations per second\n",
+	   runs, steps, threads, kernel->name,
+	   evals / (wall_clock_time () - start + 1e-9));
+
+  for (i = 0; i < model->num_bad; i++)
+    if (hit_steps[i])
+      print_parallel_witness (i, hit_runs[i], hit_steps[i]);
+
+  free (workers);
+  free (hit_runs);
+  free (hit_steps);
+  free (rhs1s);
+  free (rhs0s);
+}
+
+/*------------------------------------------------------------------------*/
+/* Compiled simulation ('-C').  The ANDs of the reencoded model are turned
+ * into straight-line C code with one statement per AND on the three-valued
+ * 'current' array.  This code is compiled with '$CC' (default 'cc') into a
+ * shared object and loaded.  Shared objects are cached under a hash of the
+ * model, '$CC' and the target in '$AIGSIM_CACHE', which defaults to the
+ * private directory '$XDG_CACHE_HOME/aigsim' (or '$HOME/.cache/aigsim').
+ */
+typedef void (*compiled_ands) (unsigned char *);
+
+#ifdef AIGER_HAVE_DLOPEN
+
+#define COMPILED_VERSION 1	/* of the generated code */
+#define COMPILED_CHUNK 32	/* statements per generated function */
+
+static void *compiled_handle;
+
+static uint64_t
+hash_unsigned (uint64_t hash, unsigned u)
+{
+  return (hash ^ u) * 1099511628211ull;
+}
+
+/* Shared objects of other compilers or architectures, e.g., in a home
+ * directory shared over the network, can not be loaded.  Thus the compiler
+ * and the target of 'aigsim' itself are part of the hash.
+ */
+#if defined(__x86_64__)
+#define COMPILED_ARCH "x86_64"
+#elif defined(__i386__)
+#define COMPILED_ARCH "i386"
+#elif defined(__aarch64__)
+#define COMPILED_ARCH "aarch64"
+#elif defined(__arm__)
+#define COMPILED_ARCH "arm"
+#elif defined(__powerpc64__)
+#define COMPILED_ARCH "powerpc64"
+#elif defined(__riscv)
+#define COMPILED_ARCH "riscv"
+#else
+#define COMPILED_ARCH "unknown"
+#endif
+
+#ifdef __VERSION__
+#define COMPILED_TARGET COMPILED_ARCH " " __VERSION__
+#else
+#define COMPILED_TARGET COMPILED_ARCH
+#endif
+
+static uint64_t
+hash_string (uint64_t hash, const char *str)
+{
+  const char *p;
+
+  for (p = str; *p; p++)
+    hash = hash_unsigned (hash, (unsigned char) *p);
+
+  return hash_unsigned (hash, 0);
+}
+
+static uint64_t
+hash_model (const char *cc)
+{
+  uint64_t res = 14695981039346656037ull;
+  unsigned i;
+
+  res = hash_unsigned (res, COMPILED_VERSION);
+  res = hash_string (res, cc);
+  res = hash_string (res, COMPILED_TARGET);
+  res = hash_unsigned (res, (unsigned) sizeof (void *));
+  res = hash_unsigned (res, model->maxvar);
+  res = hash_unsigned (res, model->num_ands);
+  for (i = 0; i < model->num_ands; i++)
+    {
+      res = hash_unsigned (res, model->ands[i].lhs);
+      res = hash_unsigned (res, model->ands[i].rhs0);
+      res = hash_unsigned (res, model->ands[i].rhs1);
+    }
+
+  return mix64 (res);
+}
+
+static void
+print_compiled_operand (FILE * file, unsigned lit)
+{
+  fprintf (file, aiger_sign (lit) ? "(c[%u] ^ 1)" : "c[%u]",
+	   aiger_lit2var (lit));
+}
+
+/* Same three-valued AND as in 'main'.  Compilers spend time quadratic in
+ * the number of memory accesses of a function.  Thus statements are split
+ * into small global functions, which are not inlined into each other when
+ * compiled with '-fPIC'.
+ */
+static void
+write_compiled_ands (FILE * file)
+{
+  unsigned i, chunks;
+  aiger_and *and;
+
+  fputs ("/* generated by 'aigsim -C' */\n"
+	 "#define a(L,R) \\\n"
+	 "  ((unsigned char) (((L) & (R)) | ((L) & ((R) << 1)) | "
+	 "((R) & ((L) << 1))))\n", file);
+
+  for (i = 0; i < model->num_ands; i++)
+    {
+      if (!(i % COMPILED_CHUNK))
+	fprintf (file, "%svoid\naigsim_s%u (unsigned char *c)\n{\n",
+		 i ? "}\n" : "", i / COMPILED_CHUNK);
+      and = model->ands + i;
+      fprintf (file, "  c[%u] = a (", aiger_lit2var (and->lhs));
+      print_compiled_operand (file, and->rhs0);
+      fputs (", ", file);
+      print_compiled_operand (file, and->rhs1);
+      fputs (");\n", file);
+    }
+  if (model->num_ands)
+    fputs ("}\n", file);
+
+  chunks = (model->num_ands + COMPILED_CHUNK - 1) / COMPILED_CHUNK;
+  fputs ("void\naigsim_simulate_ands (unsigned char *c)\n{\n", file);
+  for (i = 0; i < chunks; i++)
+    fprintf (file, "  aigsim_s%u (c);\n", i);
+  fputs ("  (void) c;\n}\n", file);
+}
+
+/* Returns the newly allocated path of the cache directory, which is
+ * created with mode 0700 if missing.  It has to be owned by the user and
+ * must not be writable by others, since we load code from it.
+ */
+static char *
+cache_directory (void)
+{
+  const char *env, *suffix;
+  struct stat buf;
+  char *res, *p, ch;
+
+  if ((env = getenv ("AIGSIM_CACHE")) && *env)
+    suffix = "";
+  else if ((env = getenv ("XDG_CACHE_HOME")) && *env)
+    suffix = "/aigsim";
+  else if ((env = getenv ("HOME")) && *env)
+    suffix = "/.cache/aigsim";
+  else
+    die ("can not determine cache directory (set '$AIGSIM_CACHE')");
+
+  if (!(res = malloc (strlen (env) + strlen (suffix) + 1)))
+    die ("out of memory");
+  sprintf (res, "%s%s", env, suffix);
+
+  for (p = res + 1;; p++)
+    {
+      if (*p && *p != '/')
+	continue;
+      ch = *p;
+      *p = 0;
+      if (mkdir (res, 0700) && errno != EEXIST)
+	die ("can not create cache directory '%s'", res);
+      if (!(*p = ch))
+	break;
+    }
+
+  if (stat (res, &buf) || !S_ISDIR (buf.st_mode) ||
+      buf.st_uid != getuid () || (buf.st_mode & (S_IWGRP | S_IWOTH)))
+    die ("cache directory '%s' not private (set '$AIGSIM_CACHE')", res);
+
+  return res;
+}
+
+/* Run '$CC' split at white space directly without a shell.
+ */
+static int
+compile_shared_object (const char *cc, const char *so_path,
+		       const char *c_path)
+{
+  char *copy, **args, *p;
+  unsigned n;
+  int status;
+  pid_t pid;
+
+  if (!(copy = strdup (cc)) ||
+      !(args = malloc ((strlen (cc) / 2 + 10) * sizeof *args)))
+    die ("out of memory");
+
+  n = 0;
+  for (p = strtok (copy, " \t"); p; p = strtok (0, " \t"))
+    args[n++] = p;
+  if (!n)
+    die ("no compiler in '$CC'");
+  args[n++] = "-O1";
+  args[n++] = "-fPIC";
+  args[n++] = "-shared";
+  args[n++] = "-o";
+  args[n++] = (char *) so_path;
+  args[n++] = "-x";
+  args[n++] = "c";
+  args[n++] = (char *) c_path;
+  args[n] = 0;
+
+  fflush (stdout);
+  if ((pid = fork ()) < 0)
+    die ("can not start compiler '%s'", args[0]);
+  if (!pid)
+    {
+      execvp (args[0], args);
+      _exit (127);
+    }
+
+  while (waitpid (pid, &status, 0) < 0)
+    if (errno != EINTR)
+      die ("can not wait for compiler '%s'", args[0]);
+
+  free (args);
+  free (copy);
+
+  return WIFEXITED (status) && !WEXITSTATUS (status);
+}
+
+static compiled_ands
+load_compiled_ands (void)
+{
+  char *dir, *so_path, *c_path, *tmp_path;
+  compiled_ands res;
+  unsigned long long hash;
+  struct stat buf;
+  const char *cc;
+  size_t len;
+  FILE *file;
+  int fd;
+
+  if (!(cc = getenv ("CC")) || !*cc)
+    cc = "cc";
+
+  dir = cache_directory ();
+  len = strlen (dir) + 64;
+  so_path = malloc (len);
+  c_path = malloc (len);
+  tmp_path = malloc (len);
+  if (!so_path || !c_path || !tmp_path)
+    die ("out of memory");
+
+  hash = hash_model (cc);
+  sprintf (so_path, "%s/aigsim-%016llx.so", dir, hash);
+
+  if (lstat (so_path, &buf))
+    {
+      /* Compile under a unique name and rename it afterwards, such that
+       * concurrent runs never load a partially written object.
+       */
+      sprintf (c_path, "%s/aigsim-%016llx-XXXXXX", dir, hash);
+      sprintf (tmp_path, "%s/aigsim-%016llx-XXXXXX", dir, hash);
+
+      if ((fd = mkstemp (c_path)) < 0 || !(file = fdopen (fd, "w")))
+	die ("can not create temporary file in '%s'", dir);
+      write_compiled_ands (file);
+      if (fclose (file))
+	die ("can not write '%s'", c_path);
+
+      if ((fd = mkstemp (tmp_path)) < 0)
+	die ("can not create temporary file in '%s'", dir);
+      close (fd);
+
+      if (!compile_shared_object (cc, tmp_path, c_path))
+	{
+	  unlink (tmp_path);
+	  die ("failed to compile '%s'", c_path);
+	}
+
+      unlink (c_path);
+      if (chmod (tmp_path, 0700) || rename (tmp_path, so_path))
+	die ("can not rename '%s' to '%s'", tmp_path, so_path);
+
+      if (lstat (so_path, &buf))
+	die ("can not access '%s'", so_path);
+    }
+
+  if (!S_ISREG (buf.st_mode) || buf.st_uid != getuid () ||
+      (buf.st_mode & (S_IWGRP | S_IWOTH)))
+    die ("refusing to load '%s' (wrong type, owner or permissions)",
+	 so_path);
+
+  if (!(compiled_handle = dlopen (so_path, RTLD_NOW)))
+    die ("can not load '%s': %s", so_path, dlerror ());
+
+  *(void **) &res = dlsym (compiled_handle, "aigsim_simulate_ands");
+  if (!res)
+    die ("can not find simulation function in '%s'", so_path);
+
+  free (tmp_path);
+  free (c_path);
+  free (so_path);
+  free (dir);
+
+  return res;
+}
+
+#endif
+
+/*------------------------------------------------------------------------*/
+/* Event-driven simulation ('-e').  Only ANDs in the transitive fanout of
+ * inputs and latches which changed their value are evaluated again.  ANDs
+ * are scheduled in one bucket per level of the cached fanout index of the
+ * library and buckets are processed in increasing level order, thus every
+ * scheduled AND is evaluated at most once per step.
+ */
+static const aiger_fanouts *fanouts;
+static unsigned max_level;
+static unsigned *event_start;	/* first queue position of each level */
+static unsigned *event_top;	/* next free queue position of each level */
+static unsigned *event_queue;	/* scheduled AND variables */
+static unsigned char *scheduled;
+static unsigned long long event_steps, event_evaluations;
+
+static void
+init_events (void)
+{
+  unsigned i, var, level;
+
+  fanouts = aiger_get_fanouts (model);
+
+  max_level = 0;
+  for (var = 0; var <= model->maxvar; var++)
+    if (fanouts->levels[var] > max_level)
+      max_level = fanouts->levels[var];
+
+  event_start = calloc (max_level + 2, sizeof (event_start[0]));
+  event_top = calloc (max_level + 1, sizeof (event_top[0]));
+  event_queue = calloc (model->num_ands + 1, sizeof (event_queue[0]));
+  scheduled = calloc (model->maxvar + 1, sizeof (scheduled[0]));
+  if (!event_start || !event_top || !event_queue || !scheduled)
+    die ("out of memory");
+
+  for (i = 0; i < model->num_ands; i++)
+    event_start[fanouts->levels[aiger_lit2var (model->ands[i].lhs)] + 1]++;
+  for (level = 1; level <= max_level + 1; level++)
+    event_start[level] += event_start[level - 1];
+}
+
+static void
+reset_events (void)
+{
+  free (scheduled);
+  free (event_queue);
+  free (event_top);
+  free (event_start);
+}
+
+static void
+schedule (unsigned var)
+{
+  unsigned level;
+
+  if (scheduled[var])
+    return;
+
+  scheduled[var] = 1;
+  level = fanouts->levels[var];
+  event_queue[event_top[level]++] = var;
+}
+
+static void
+schedule_fanouts (unsigned var)
+{
+  aiger_lit p, end;
+
+  end = fanouts->offsets[var + 1];
+  for (p = fanouts->offsets[var]; p < end; p++)
+    schedule (aiger_lit2var (fanouts->targets[p]));
+}
+
+/* Forget pending events and schedule all ANDs, which is necessary before
+ * the first step, since initially all ANDs have the value '0'.
+ */
+static void
+schedule_all_ands (void)
+{
+  unsigned i, level;
+
+  for (level = 0; level <= max_level; level++)
+    event_top[level] = event_start[level];
+  memset (scheduled, 0, model->maxvar + 1);
+
+  for (i = 0; i < model->num_ands; i++)
+    schedule (aiger_lit2var (model->ands[i].lhs));
+}
+
+/* Set the value of an input or latch and schedule its fanouts if the value
+ * changed.  Without '-e' there is no fanout index and it is only assigned.
+ */
+static void
+assign (unsigned var, unsigned char value)
+{
+  if (fanouts && current[var] != value)
+    schedule_fanouts (var);
+  current[var] = value;
+}
+
+/* Same three-valued AND as in 'main'.  Fanouts are always on a higher level
+ * than the evaluated AND and thus scheduled into a bucket not yet
+ * processed.  The first AND variable follows inputs and latches after
+ * reencoding.
+ */
+static void
+simulate_events (void)
+{
+  unsigned level, p, var, l, r, tmp, first;
+  aiger_and *and;
+
+  first = model->num_inputs + model->num_latches + 1;
+
+  for (level = 1; level <= max_level; level++)
+    {
+      for (p = event_start[level]; p < event_top[level]; p++)
+	{
+	  var = event_queue[p];
+	  scheduled[var] = 0;
+	  and = model->ands + (var - first);
+	  assert (aiger_lit2var (and->lhs) == var);
+	  l = deref (and->rhs0);
+	  r = deref (and->rhs1);
+	  tmp = l & r;
+	  tmp |= l & (r << 1);
+	  tmp |= r & (l << 1);
+	  if (tmp != current[var])
+	    {
+	      current[var] = tmp;
+	      schedule_fanouts (var);
+	    }
+	}
+
+      event_evaluations += event_top[level] - event_start[level];
+      event_top[level] = event_start[level];
+    }
+
+  event_steps++;
+}
+
+static void
+report_events (void)
+{
+  double per_step, percent;
+
+  per_step = event_steps ? event_evaluations / (double) event_steps : 0;
+  percent = model->num_ands ? 100.0 * per_step / model->num_ands : 0;
+
+  fprintf (stderr,
+	   "[aigsim] events: %llu gate evaluations in %llu steps\n"
+	   "[aigsim] events: %.1f gate evaluations per step "
+	   "(%.1f%% of %u ANDs)\n",
+	   event_evaluations, event_steps, per_step, percent,
+	   model->num_ands);
+}
+
 static const char * USAGE =
 "usage: aigsim [<option> ...] [ <model> [<stimulus>] ]\n"
 "\n"
@@ -168,6 +1157,16 @@ static const char * USAGE =
 "-3              enable three valued stimulus in random simulation\n"
 "-r <vectors>    random stimulus of <vectors> input vectors\n"
 "-s <seed>       set seed of random number generator (default '0')\n"
+"-p <runs>       bit-parallel random simulation of <runs> independent runs\n"
+"                of '-r <vectors>' steps (prints a witness for the first\n"
+"                run hitting each bad state property)\n"
+"-k <kernel>     kernel for '-p' ('word', 'avx2' or 'avx512', default is\n"
+"                the widest one supported by the CPU and number of runs)\n"
+"-j <threads>    number of threads for '-p' (default '1')\n"
+"-C              compiled simulation (cached in '$AIGSIM_CACHE' or\n"
+"                '$XDG_CACHE_HOME/aigsim' or '~/.cache/aigsim')\n"
+"-e              event-driven simulation of changed inputs and latches\n"
+"                (prints gate evaluations per step to '<stderr>')\n"
 ;
 
 #define ALLOC_STATES 100
@@ -175,8 +1174,10 @@ static const char * USAGE =
 int
 main (int argc, char **argv)
 {
-  int vectors, check, move, vcd, print, three, ground, seeded, delay;
-  const char *stimulus_file_name, *model_file_name, *error;
+  int vectors, check, move, vcd, print, three, ground, seeded, delay, runs;
+  int threads, compiled, events;
+  compiled_ands simulate_ands;
+  const char *stimulus_file_name, *model_file_name, *error, *kernel_name;
   unsigned i, j, s, l, r, tmp, seed, period;
   int witness, ch, res, och, checkpass;
   /* SW110525 Variables for finding fair loops
@@ -192,10 +1193,15 @@ main (int argc, char **argv)
   int findloop, requireloop, constraintViolation;
   int foundfair, looppoint;
 
-  stimulus_file_name = model_file_name = 0;
+  stimulus_file_name = model_file_name = kernel_name = 0;
   delay = seeded = vcd = check = 0;
   move = witness = 0;
   vectors = -1;
+  runs = 0;
+  threads = 0;
+  compiled = 0;
+  events = 0;
+  simulate_ands = 0;
   ground = three = 0;
   seed = 0;
 
@@ -222,6 +1228,10 @@ main (int argc, char **argv)
 	three = 1;
       else if (!strcmp (argv[i], "-2"))
 	ground = 1;
+      else if (!strcmp (argv[i], "-C"))
+	compiled = 1;
+      else if (!strcmp (argv[i], "-e"))
+	events = 1;
       else if (!strcmp (argv[i], "-s"))
 	{
 	  if (i + 1 == argc)
@@ -237,6 +1247,31 @@ main (int argc, char **argv)
 
 	  vectors = atoi (argv[++i]);
 	}
+      else if (!strcmp (argv[i], "-p"))
+	{
+	  if (i + 1 == argc)
+	    die ("argument to '-p' missing");
+
+	  runs = atoi (argv[++i]);
+	  if (runs <= 0)
+	    die ("invalid number of runs '%s'", argv[i]);
+	}
+      else if (!strcmp (argv[i], "-k"))
+	{
+	  if (i + 1 == argc)
+	    die ("argument to '-k' missing");
+
+	  kernel_name = argv[++i];
+	}
+      else if (!strcmp (argv[i], "-j"))
+	{
+	  if (i + 1 == argc)
+	    die ("argument to '-j' missing");
+
+	  threads = atoi (argv[++i]);
+	  if (threads <= 0)
+	    die ("invalid number of threads '%s'", argv[i]);
+	}
       else if (argv[i][0] == '-')
 	die ("invalid option '%s' (try '-h')", argv[i]);
       else if (!model_file_name)
@@ -271,6 +1306,29 @@ main (int argc, char **argv)
   if (!vcd && delay)
     die ("can not use '-d' without '-v'");
 
+  if (runs && vectors < 0)
+    die ("can not use '-p' without '-r <vectors>'");
+
+  if (runs && (three || vcd))
+    die ("can not combine '-p' with '-3' or '-v'");
+
+  if (kernel_name && !runs)
+    die ("can not use '-k' without '-p <runs>'");
+
+  if (threads && !runs)
+    die ("can not use '-j' without '-p <runs>'");
+
+  if (compiled && runs)
+    die ("can not combine '-C' with '-p <runs>'");
+
+  if (events && (runs || compiled))
+    die ("can not combine '-e' with '-p <runs>' or '-C'");
+
+#ifndef AIGER_HAVE_DLOPEN
+  if (compiled)
+    die ("compiled simulation not supported (no 'dlopen')");
+#endif
+
   model = aiger_init ();
 
   if (model_file_name)
@@ -294,6 +1352,22 @@ main (int argc, char **argv)
 
   aiger_reencode (model);	/* otherwise simulation incorrect */
 
+  if (runs)
+    {
+      simulate_parallel (runs, vectors, seed, kernel_name,
+			 threads ? threads : 1);
+      aiger_reset (model);
+      return 0;
+    }
+
+#ifdef AIGER_HAVE_DLOPEN
+  if (compiled)
+    simulate_ands = load_compiled_ands ();
+#endif
+
+  if (events)
+    init_events ();
+
   if (stimulus_file_name)
     {
       file = fopen (stimulus_file_name, "r");
@@ -489,6 +1563,9 @@ readNextWitness:
 	}
     }
 
+  if (events)
+    schedule_all_ands ();
+
   i = 1;
   while (vectors)
     {
@@ -500,7 +1577,7 @@ readNextWitness:
 	      s %= 20;
 	      tmp = rand () >> s;
 	      tmp %= three + 2;
-	      current[j] = tmp;
+	      assign (j, tmp);
 	    }
 
 	  vectors--;
@@ -518,11 +1595,11 @@ readNextWitness:
 	  while (j <= model->num_inputs)
 	    {
 	      if (ch == '0')
-		current[j] = 0;
+		assign (j, 0);
 	      else if (ch == '1')
-		current[j] = 1;
+		assign (j, 1);
 	      else if (ch == 'x')
-		current[j] = ground ? 0 : 2;
+		assign (j, ground ? 0 : 2);
 	      else
 		die ("line %u: pos %u: expected '0' or '1'", i, j);
 
@@ -536,16 +1613,21 @@ readNextWitness:
 
       /* Simulate AND nodes.
        */
-      for (j = 0; j < model->num_ands; j++)
-	{
-	  aiger_and *and = model->ands + j;
-	  l = deref (and->rhs0);
-	  r = deref (and->rhs1);
-	  tmp = l & r;
-	  tmp |= l & (r << 1);
-	  tmp |= r & (l << 1);
-	  current[and->lhs / 2] = tmp;
-	}
+      if (events)
+	simulate_events ();
+      else if (simulate_ands)
+	simulate_ands (current);
+      else
+	for (j = 0; j < model->num_ands; j++)
+	  {
+	    aiger_and *and = model->ands + j;
+	    l = deref (and->rhs0);
+	    r = deref (and->rhs1);
+	    tmp = l & r;
+	    tmp |= l & (r << 1);
+	    tmp |= r & (l << 1);
+	    current[and->lhs / 2] = tmp;
+	  }
 
       /* Check consistency with reset functions */
       if (i == 1 && witness)
@@ -684,7 +1766,7 @@ readNextWitness:
       for (j = 0; j < model->num_latches; j++)
 	{
 	  aiger_symbol *symbol = model->latches + j;
-	  current[symbol->lit / 2] = next[j];
+	  assign (symbol->lit / 2, next[j]);
 	}
 
       if (vcd)
@@ -814,9 +1896,20 @@ DONE:
 
   free (prop_result);
 
+  if (events)
+    {
+      report_events ();
+      reset_events ();
+    }
+
   if (close_file)
     fclose (file);
 
+#ifdef AIGER_HAVE_DLOPEN
+  if (compiled_handle)
+    dlclose (compiled_handle);
+#endif
+
   aiger_reset (model);
 
   return res;
@@ -67,14 +67,13 @@ aigtoaig_free (memory * m, void *ptr, size_t bytes)
   free (ptr);
 }
 
-static int
-aigtoaig_put (char ch, stream * stream)
+static size_t
+aigtoaig_put_block (const char *buffer, size_t size, stream * stream)
 {
-  int res;
+  size_t res;
 
-  res = putc ((unsigned char) ch, stream->file);
-  if (res != EOF)
-    stream->bytes++;
+  res = fwrite (buffer, 1, size, stream->file);
+  stream->bytes += res;
 
   return res;
 }
@@ -113,7 +112,7 @@ die (const char *fmt, ...)
 }
 
 #define USAGE \
-"usage: aigtoaig [-h][-v][-s][-a][-t<n>][src [dst]]\n" \
+"usage: aigtoaig [-h][-v][-s][-a][-t<n>][-j <n>][src [dst]]\n" \
 "\n" \
 "This is an utility to translate files in AIGER format.\n" \
 "\n" \
@@ -122,6 +121,7 @@ die (const char *fmt, ...)
 "  -a        output in ASCII AIGER '.aag' format\n" \
 "  -s        strip symbols and comments of the output file\n" \
 "  -t[ ]<n>  truncate outputs and keep only the first '<n>'\n" \
+"  -j <n>    write binary output with '<n>' threads\n" \
 "  src       input file or '-' for 'stdin'\n" \
 "  dst       output file or '-' for 'stdout'\n" \
 "\n" \
@@ -141,6 +141,7 @@ main (int argc, char **argv)
   const char *src, *dst, *src_name, *dst_name, *error;
   int verbose, ascii, strip, res;
   unsigned truncated_outputs;
+  unsigned threads;
   stream reader, writer;
   unsigned num_outputs;
   int truncate_outputs;
@@ -156,6 +157,7 @@ main (int argc, char **argv)
   remove_outputs = 0;
   truncate_outputs = 0;
   num_outputs = 0;
+  threads = 1;
 
   for (i = 1; i < argc; i++)
     {
@@ -192,6 +194,14 @@ main (int argc, char **argv)
             truncated_outputs = (unsigned) atoi (arg);
             truncate_outputs = 1;
           }
+      } else if (!strcmp (arg, "-j")) {
+        if (++i == argc)
+          die ("argument to '-j' missing");
+        arg = argv[i];
+        for (const char * p = arg; *p; p++)
+          if (!isdigit (*p))
+            die ("invalid command line option '-j %s'", arg);
+        threads = (unsigned) atoi (arg);
       } else if (!strcmp (arg, "--remove-outputs"))
 	remove_outputs = 1;
       else if (arg[0] == '-' && arg[1])
@@ -319,6 +329,8 @@ main (int argc, char **argv)
 	  aiger->num_outputs = truncated_outputs;
         }
 
+      aiger_write_threads (aiger, threads);
+
       if (dst)
 	{
 	  if (aiger_open_and_write_to_file (aiger, dst))
@@ -351,8 +363,8 @@ main (int argc, char **argv)
 	  else
 	    mode = aiger_binary_mode;
 
-	  if (!aiger_write_generic (aiger, mode,
-				    &writer, (aiger_put) aigtoaig_put))
+	  if (!aiger_write_blocks (aiger, mode, &writer,
+				   (aiger_put_block) aigtoaig_put_block))
 	    goto WRITE_ERROR;
 
 	  if (verbose)
@@ -244,6 +244,7 @@ int main(int argc, char **argv) {
   }
 
   aiger = aiger_init();
+  aiger_lazy_symbols(aiger);	/* names are never used */
 
   if (input_name)
     error = aiger_open_and_read_from_file(aiger, input_name);
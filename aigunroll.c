@@ -353,7 +353,7 @@ expand (void)
 }
 
 #define USAGE \
-"usage: aigunroll [-h][-v][-a][-s][<k>][<src>[<dst>]]\n" \
+"usage: aigunroll [-h][-v][-a][-s][-j <threads>][<k>][<src>[<dst>]]\n" \
 "\n" \
 "where\n" \
 "\n" \
@@ -362,6 +362,7 @@ expand (void)
 "  -a     force ASCII output\n" \
 "  -s     strip symbols from target model\n" \
 "  -u     unroll only ignoring all properties\n" \
+"  -j <n> write binary target model with <n> threads\n" \
 "  <k>    bound (default 0)\n" \
 "  <src>  sequential source model in AIGER format\n" \
 "  <dst>  combinational target model in AIGER format\n"
@@ -370,12 +371,14 @@ int
 main (int argc, char **argv)
 {
   const char *src, *dst, *p, *err;
+  unsigned threads;
   aiger_mode mode;
   simpaig *res;
   int i, ascii;
 
   src = dst = 0;
   ascii = 0;
+  threads = 1;
 
   for (i = 1; i < argc; i++)
     {
@@ -397,6 +400,16 @@ main (int argc, char **argv)
 	unroll = 1;
       else if (!strcmp (argv[i], "-v"))
 	verbose++;
+      else if (!strcmp (argv[i], "-j"))
+	{
+	  if (++i == argc)
+	    die ("argument to '-j' missing");
+
+	  for (p = argv[i]; *p; p++)
+	    if (!isdigit (*p))
+	      die ("invalid command line option '-j %s'", argv[i]);
+	  threads = (unsigned) atoi (argv[i]);
+	}
       else if (argv[i][0] == '-')
 	die ("invalid command line option '%s'", argv[i]);
       else if (!src)
@@ -472,6 +485,8 @@ main (int argc, char **argv)
 
   free (lois);
 
+  aiger_write_threads (expansion, threads);
+
   if (dst)
     {
       if (!aiger_open_and_write_to_file (expansion, dst))
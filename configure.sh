@@ -1,11 +1,16 @@
 #!/bin/sh
 debug=no
+zlib=yes
+lzma=yes
+zstd=yes
+pthread=yes
+dlopen=yes
 die () {
   echo "*** configure.sh: $*" 1>&2
   exit 1
 }
 usage () {
-  echo "usage: [CC=compile] [CFLAGS=cflags] configure.sh [-h][-hg]"
+  echo "usage: [CC=compile] [CFLAGS=cflags] configure.sh [-h][-hg][--no-{zlib,lzma,zstd,pthread,dlopen}]"
   exit 0
 }
 wrn () {
@@ -20,6 +25,11 @@ do
     -h|--help) usage;;
     -g) debug=yes;;
     -static) static=yes;;
+    --no-zlib) zlib=no;;
+    --no-lzma) lzma=no;;
+    --no-zstd) zstd=no;;
+    --no-pthread) pthread=no;;
+    --no-dlopen) dlopen=no;;
     *) die "invalid command line option '$1' (try '-h')";;
   esac
   shift
@@ -61,6 +71,58 @@ else
   msg "using custom compilation flags"
 fi
 
+# Check whether a library (for in-process compression, threads or loading
+# compiled simulation code) can be used by compiling and linking a small
+# test program against it.
+
+havelib () {
+  rm -f conftest.c conftest
+  printf '#include <%s>\nint main (void) { %s; return 0; }\n' "$2" "$3" \
+    > conftest.c
+  if $CC $CFLAGS -o conftest conftest.c $4 1>/dev/null 2>&1
+  then
+    res=0
+    msg "using $1"
+  else
+    res=1
+    wrn "can not find $1"
+  fi
+  rm -f conftest.c conftest
+  return $res
+}
+
+LIBS=""
+
+if [ $zlib = yes ] && havelib zlib zlib.h "gzopen (0, 0)" -lz
+then
+  CFLAGS="$CFLAGS -DAIGER_HAVE_ZLIB"
+  LIBS="$LIBS -lz"
+fi
+
+if [ $lzma = yes ] && havelib liblzma lzma.h "lzma_end (0)" -llzma
+then
+  CFLAGS="$CFLAGS -DAIGER_HAVE_LZMA"
+  LIBS="$LIBS -llzma"
+fi
+
+if [ $zstd = yes ] && havelib libzstd zstd.h "ZSTD_createDStream ()" -lzstd
+then
+  CFLAGS="$CFLAGS -DAIGER_HAVE_ZSTD"
+  LIBS="$LIBS -lzstd"
+fi
+
+if [ $pthread = yes ] && havelib pthreads pthread.h "pthread_self ()" -pthread
+then
+  CFLAGS="$CFLAGS -DAIGER_HAVE_PTHREAD"
+  LIBS="$LIBS -pthread"
+fi
+
+if [ $dlopen = yes ] && havelib dlopen dlfcn.h "dlopen (0, 0)" -ldl
+then
+  CFLAGS="$CFLAGS -DAIGER_HAVE_DLOPEN"
+  LIBS="$LIBS -ldl"
+fi
+
 AIGBMCFLAGS="$CFLAGS"
 AIGDEPCFLAGS="$CFLAGS"
 
@@ -137,10 +199,12 @@ else
 fi
 
 msg "compiling with: $CC $CFLAGS"
+msg "linking with: $LIBS"
 rm -f makefile
 sed \
   -e "s/@CC@/$CC/" \
   -e "s/@CFLAGS@/$CFLAGS/" \
+  -e "s,@LIBS@,$LIBS," \
   -e "s/@AIGBMCTARGET@/$AIGBMCTARGET/" \
   -e "s/@AIGBMCTARGET@/$AIGBMCTARGET/" \
   -e "s,@AIGBMCHDEPS@,$AIGBMCHDEPS," \
@@ -1,9 +1,15 @@
-all: testaigtoaig testsimpaig
+all: testaigtoaig testaigtoaig64 testsimpaig
 testaigtoaig: aiger.o testaigtoaig.o makefile
-	$(CC) $(CFLAGS) -o $@ testaigtoaig.o aiger.o
+	$(CC) $(CFLAGS) -o $@ testaigtoaig.o aiger.o $(LIBS)
+testaigtoaig64: aiger64.o testaigtoaig64.o makefile
+	$(CC) $(CFLAGS) -o $@ testaigtoaig64.o aiger64.o $(LIBS)
 testsimpaig: simpaig.o testsimpaig.o makefile
 	$(CC) $(CFLAGS) -o $@ testsimpaig.o simpaig.o
 testaigtoaig.o: testaigtoaig.c aiger.h makefile
+aiger64.o: aiger.c aiger.h makefile
+	$(CC) $(CFLAGS) -DAIGER_WIDE -c -o $@ aiger.c
+testaigtoaig64.o: testaigtoaig.c aiger.h makefile
+	$(CC) $(CFLAGS) -DAIGER_WIDE -c -o $@ testaigtoaig.c
 testsimpaig.o: testsimpaig.c simpaig.h makefile
 clean: testclean
 testclean:
@@ -11,5 +17,5 @@ testclean:
 	rm -f log/*.aig log/*.aag
 	rm -f log/*.aig.gz log/*.aag.gz
 	rm -f log/*.log log/*.err
-	rm -f testaigtoaig testsimpaig
+	rm -f testaigtoaig testaigtoaig64 testsimpaig
 .PHONY: testclean
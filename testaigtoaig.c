@@ -22,8 +22,10 @@ IN THE SOFTWARE.
 
 #include "aiger.h"
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #ifdef NDEBUG
 #undef NDEBUG
@@ -61,6 +63,16 @@ test_free (test_memory_mgr * mgr, void *ptr, size_t bytes)
   free (ptr);
 }
 
+static void *
+test_realloc (test_memory_mgr * mgr, void *ptr,
+	      size_t old_bytes, size_t new_bytes)
+{
+  assert (mgr->bytes >= old_bytes);
+  mgr->bytes -= old_bytes;
+  mgr->bytes += new_bytes;
+  return realloc (ptr, new_bytes);
+}
+
 static test_memory_mgr mgr;
 
 static aiger *
@@ -146,6 +158,32 @@ cyclic1 (void)
   assert (!mgr.bytes);
 }
 
+static void
+check_cached (void)
+{
+  aiger *aiger = my_aiger_init ();
+  aiger_add_input (aiger, 2, 0);
+  aiger_add_and (aiger, 4, 6, 2);	/* needs search */
+  aiger_add_and (aiger, 6, 3, 2);
+  aiger_add_output (aiger, 4, 0);
+  assert (!aiger_check (aiger));
+  assert (!aiger_check (aiger));
+  aiger->ands[1].rhs0 = 5;		/* now cyclic */
+  aiger_changed (aiger);
+  assert (aiger_check (aiger));
+  aiger_reset (aiger);
+  assert (!mgr.bytes);
+
+  aiger = my_aiger_init ();
+  aiger_add_input (aiger, 2, 0);
+  aiger_add_and (aiger, 4, 3, 2);
+  assert (!aiger_check (aiger));
+  aiger_add_and (aiger, 6, 8, 2);	/* undefined */
+  assert (aiger_check (aiger));
+  aiger_reset (aiger);
+  assert (!mgr.bytes);
+}
+
 static void
 write_and_read_fmt (aiger * old, const char *name, const char *fmt)
 {
@@ -290,6 +328,747 @@ reencode_counter1 (void)
   assert (!mgr.bytes);
 }
 
+typedef struct test_blocks test_blocks;
+
+struct test_blocks
+{
+  char buffer[200];
+  size_t pos, len;
+};
+
+static size_t
+test_put_block (const char *buffer, size_t size, test_blocks * blocks)
+{
+  assert (blocks->len + size <= sizeof (blocks->buffer));
+  memcpy (blocks->buffer + blocks->len, buffer, size);
+  blocks->len += size;
+  return size;
+}
+
+static size_t
+test_get_block (char *buffer, size_t size, test_blocks * blocks)
+{
+  size_t res = blocks->len - blocks->pos;
+  if (res > 3)
+    res = 3;			/* force many small blocks */
+  if (res > size)
+    res = size;
+  memcpy (buffer, blocks->buffer + blocks->pos, res);
+  blocks->pos += res;
+  return res;
+}
+
+static void
+write_and_read_blocks (void)
+{
+  aiger *aiger = my_aiger_init ();
+  test_blocks blocks;
+  char buffer[200];
+
+  assert (!aiger_read_from_string (aiger, counter1));
+  memset (&blocks, 0, sizeof blocks);
+  assert (aiger_write_blocks (aiger, aiger_binary_mode,
+			      &blocks, (aiger_put_block) test_put_block));
+  aiger_reset (aiger);
+
+  aiger = my_aiger_init ();
+  assert (!aiger_read_blocks (aiger,
+			      &blocks, (aiger_get_block) test_get_block));
+  assert (aiger_write_to_string (aiger, aiger_ascii_mode, buffer, 200));
+  assert (!strcmp (buffer, counter1r));
+  assert (!aiger_write_to_string (aiger, aiger_ascii_mode,
+				  buffer, strlen (counter1r)));
+  aiger_reset (aiger);
+  assert (!mgr.bytes);
+}
+
+static void
+coi_and_coi_of_lits (void)
+{
+  aiger *aiger = my_aiger_init ();
+  const unsigned char *coi;
+  aiger_lit lit;
+
+  aiger_add_input (aiger, 2, 0);
+  aiger_add_input (aiger, 4, 0);
+  aiger_add_latch (aiger, 6, 8, 0);
+  aiger_add_and (aiger, 8, 6, 3);
+  aiger_add_and (aiger, 10, 4, 7);	/* only in cone of bad */
+  aiger_add_output (aiger, 7, 0);
+
+  coi = aiger_coi (aiger);
+  assert (coi[1] && !coi[2] && coi[3] && coi[4] && !coi[5]);
+  assert (coi == aiger_coi (aiger));
+
+  aiger_add_bad (aiger, 10, 0);
+  coi = aiger_coi (aiger);
+  assert (coi[1] && coi[2] && coi[3] && coi[4] && coi[5]);
+
+  lit = 4;
+  coi = aiger_coi_of_lits (aiger, &lit, 1);
+  assert (!coi[1] && coi[2] && !coi[3] && !coi[4] && !coi[5]);
+
+  coi = aiger_coi (aiger);
+  assert (coi[1] && coi[5]);
+
+  aiger_reset (aiger);
+  assert (!mgr.bytes);
+}
+
+static void
+reserve_and_realloc (void)
+{
+  aiger *aiger = aiger_init_mem_realloc (&mgr,
+					 (aiger_malloc) test_malloc,
+					 (aiger_realloc) test_realloc,
+					 (aiger_free) test_free);
+  unsigned i;
+
+  aiger_reserve (aiger, 8, 2, 1, 1, 4, 0, 0, 0, 0);
+  assert (!aiger_read_from_string (aiger, counter1));
+  for (i = 9; i < 100; i++)
+    aiger_add_input (aiger, 2 * i, 0);	/* grow in place */
+  aiger_reencode (aiger);
+  assert (aiger->maxvar == 98);
+  assert (aiger->num_inputs == 93);
+  assert (!aiger_check (aiger));
+  aiger_reset (aiger);
+  assert (!mgr.bytes);
+}
+
+static void
+compact_ands (void)
+{
+  aiger *aiger = my_aiger_init ();
+  test_blocks blocks;
+  char buffer[200];
+  aiger_and *and;
+
+  aiger_compact (aiger);
+  assert (!aiger_read_from_string (aiger, counter1));
+  assert (aiger->compact && !aiger->ands);
+  assert (aiger_and_lhs (aiger, 0) == 8);
+  assert (aiger_and_rhs0 (aiger, 3) == 12);
+  assert (aiger_and_rhs1 (aiger, 3) == 3);
+  and = aiger_is_and (aiger, 15);
+  assert (and && and->lhs == 14 && and->rhs0 == 12 && and->rhs1 == 3);
+  assert (aiger_write_to_string (aiger, aiger_ascii_mode, buffer, 200));
+  assert (!strcmp (buffer, counter1r));
+
+  memset (&blocks, 0, sizeof blocks);
+  assert (aiger_write_blocks (aiger, aiger_binary_mode,
+			      &blocks, (aiger_put_block) test_put_block));
+  aiger_reset (aiger);
+
+  aiger = my_aiger_init ();
+  aiger_compact (aiger);
+  assert (!aiger_read_blocks (aiger,
+			      &blocks, (aiger_get_block) test_get_block));
+  assert (aiger->compact);
+  assert (aiger_write_to_string (aiger, aiger_ascii_mode, buffer, 200));
+  assert (!strcmp (buffer, counter1r));
+  aiger_reset (aiger);
+
+  aiger = my_aiger_init ();
+  aiger_add_input (aiger, 2, 0);
+  aiger_add_and (aiger, 4, 2, 3);
+  aiger_add_output (aiger, 4, 0);	/* otherwise removed */
+  aiger_compact (aiger);
+  aiger_add_and (aiger, 6, 3, 5);
+  aiger_add_output (aiger, 7, 0);
+  assert (aiger_and_rhs0 (aiger, 1) == 5);
+  assert (aiger_and_rhs1 (aiger, 1) == 3);
+  assert (!aiger_check (aiger));
+  aiger_reset (aiger);
+  assert (!mgr.bytes);
+}
+
+static void
+header_only_and_skip_ands (void)
+{
+  aiger *aiger = my_aiger_init ();
+  aiger_header header;
+
+  assert (!aiger_read_header_only (aiger, "log/counter1.aig.gz", &header));
+  assert (header.mode == aiger_binary_mode);
+  assert (header.maxvar == 7 && header.inputs == 2 && header.latches == 1);
+  assert (header.outputs == 1 && header.ands == 4 && !header.bad);
+  assert (!aiger->maxvar && !aiger->num_inputs);
+  aiger_reset (aiger);
+
+  aiger = my_aiger_init ();
+  aiger_skip_ands (aiger);
+  assert (!aiger_read_from_string (aiger, counter1));
+  assert (!aiger->num_ands);
+  assert (!strcmp (aiger_get_symbol (aiger, 6), "latch"));
+  assert (!strcmp (aiger->comments[0], "1-bit counter with reset and enable"));
+  aiger_reset (aiger);
+
+  aiger = my_aiger_init ();
+  aiger_skip_ands (aiger);
+  assert (aiger_read_from_string (aiger, "aag 3 2 0 1 1\n2\n4\n6\n6 2"));
+  aiger_reset (aiger);
+  assert (!mgr.bytes);
+}
+
+static void
+lazy_symbols (void)
+{
+  aiger *aiger = my_aiger_init ();
+  char buffer[200];
+
+  aiger_lazy_symbols (aiger);
+  assert (!aiger_read_from_string (aiger, counter1));
+  assert (!aiger->inputs[0].name && !aiger->comments[0]);
+  assert (!strcmp (aiger_get_symbol (aiger, 4), "enable"));
+  assert (!strcmp (aiger->inputs[0].name, "reset"));
+  assert (!strcmp (aiger->comments[0], "1-bit counter with reset and enable"));
+  aiger_add_comment (aiger, "second");
+  aiger_reencode (aiger);
+  assert (aiger_write_to_string (aiger, aiger_ascii_mode, buffer, 200));
+  assert (!strncmp (buffer, counter1r, strlen (counter1r)));
+  assert (!strcmp (buffer + strlen (counter1r), "second\n"));
+  assert (aiger_strip_symbols (aiger) == 4);
+  aiger_reset (aiger);
+
+  aiger = my_aiger_init ();
+  aiger_lazy_symbols (aiger);
+  assert (!aiger_read_from_string (aiger, "aag 1 1 0 0 0\n2\ni1 x\n"));
+  assert (aiger_load_symbols (aiger));
+  aiger_reset (aiger);
+  assert (!mgr.bytes);
+}
+
+static void
+arena_names_and_strip (void)
+{
+  aiger *aiger = my_aiger_init ();
+  aiger_lit lits[2];
+  char name[20];
+  unsigned i;
+
+  for (i = 1; i <= 10000; i++)
+    {
+      sprintf (name, "i%u", i);
+      aiger_add_input (aiger, 2 * i, name);
+    }
+  lits[0] = 2;
+  lits[1] = 4;
+  aiger_add_justice (aiger, 2, lits, "j");
+  aiger_add_comment (aiger, "first");
+  assert (!strcmp (aiger_get_symbol (aiger, 20000), "i10000"));
+  assert (aiger->justice[0].lits[1] == 4);
+  assert (aiger_strip_comments (aiger) == 1);
+  assert (!aiger->comments[0]);
+  aiger_add_comment (aiger, "second");
+  assert (!strcmp (aiger->comments[0], "second") && !aiger->comments[1]);
+  assert (aiger_strip_symbols_and_comments (aiger) == 10002);
+  assert (!aiger->inputs[9999].name && !aiger->comments[0]);
+  aiger_add_input (aiger, 20002, "again");
+  assert (!strcmp (aiger_get_symbol (aiger, 20002), "again"));
+  aiger_reset (aiger);
+  assert (!mgr.bytes);
+
+  aiger = my_aiger_init ();
+  assert (!aiger_read_from_string (aiger, counter1));
+  assert (aiger_strip_symbols (aiger) == 4);
+  assert (!strcmp (aiger->comments[0], "1-bit counter with reset and enable"));
+  aiger_reset (aiger);
+  assert (!mgr.bytes);
+}
+
+static void
+find_symbols (void)
+{
+  aiger *aiger = my_aiger_init ();
+  aiger_symbol *symbol;
+  char name[20];
+  unsigned i;
+  int tag;
+
+  aiger_lazy_symbols (aiger);
+  assert (!aiger_read_from_string (aiger, counter1));
+  symbol = aiger_find_symbol (aiger, "latch", &tag);
+  assert (symbol == aiger->latches && tag == 'l');
+  symbol = aiger_find_symbol (aiger, "enable", &tag);
+  assert (symbol == aiger->inputs + 1 && tag == 'i');
+  assert (aiger_find_symbol (aiger, "AIGER_NEVER", &tag) == aiger->outputs);
+  assert (tag == 'o');
+  assert (!aiger_find_symbol (aiger, "unknown", 0));
+  aiger_add_bad (aiger, 8, "latch");
+  aiger_add_fairness (aiger, 9, "fair");
+  assert (aiger_find_symbol (aiger, "latch", &tag) == aiger->latches);
+  assert (aiger_find_symbol (aiger, "fair", &tag) == aiger->fairness);
+  assert (tag == 'f');
+  assert (aiger_strip_symbols (aiger) == 6);
+  assert (!aiger_find_symbol (aiger, "latch", 0));
+  aiger_reset (aiger);
+  assert (!mgr.bytes);
+
+  aiger = my_aiger_init ();
+  for (i = 1; i <= 10000; i++)
+    {
+      sprintf (name, "i%u", i);
+      aiger_add_input (aiger, 2 * i, name);
+    }
+  for (i = 1; i <= 10000; i++)
+    {
+      sprintf (name, "i%u", i);
+      assert (aiger_find_symbol (aiger, name, 0) == aiger->inputs + i - 1);
+    }
+  aiger_reset (aiger);
+  assert (!mgr.bytes);
+}
+
+static char *sorted_with_holes =
+  "aag 20 2 0 2 5\n"
+  "4\n"
+  "10\n"
+  "40\n"
+  "31\n"
+  "12 4 10\n"
+  "20 4 11\n"
+  "14 5 11\n"
+  "30 13 15\n"
+  "40 30 4\n";
+
+static char *sorted_with_holes_r =
+  "aag 6 2 0 2 4\n"
+  "2\n"
+  "4\n"
+  "12\n"
+  "11\n"
+  "6 4 2\n"
+  "8 5 3\n"
+  "10 9 7\n"
+  "12 10 2\n";
+
+static void
+reencode_in_order (void)
+{
+  aiger *aiger = my_aiger_init ();
+  char buffer[200];
+
+  assert (!aiger_read_from_string (aiger, sorted_with_holes));
+  aiger_reencode (aiger);
+  assert (aiger_write_to_string (aiger, aiger_ascii_mode, buffer, 200));
+  assert (!strcmp (buffer, sorted_with_holes_r));
+  aiger_reset (aiger);
+  assert (!mgr.bytes);
+}
+
+static void
+write_threads (void)
+{
+  static char expected[1 << 16], buffer[1 << 16];
+  aiger *aiger = my_aiger_init ();
+  aiger_lit lhs;
+  unsigned i;
+
+  for (i = 1; i <= 100; i++)
+    aiger_add_input (aiger, 2 * i, 0);
+  for (i = 0; i < 10000; i++)
+    {
+      lhs = 2 * (101 + i);
+      aiger_add_and (aiger, lhs, lhs - 2 - (i % 7), 2 + 2 * (i % 100));
+    }
+  aiger_add_output (aiger, lhs, 0);
+
+  assert (aiger_write_to_string (aiger, aiger_binary_mode,
+				 expected, sizeof expected));
+  aiger_write_threads (aiger, 4);
+  assert (aiger_write_to_string (aiger, aiger_binary_mode,
+				 buffer, sizeof buffer));
+  assert (!memcmp (buffer, expected, sizeof buffer));
+  assert (!aiger_write_to_string (aiger, aiger_binary_mode, buffer, 1000));
+  aiger_reset (aiger);
+  assert (!mgr.bytes);
+}
+
+static void
+read_parallel (void)
+{
+  static char expected[1 << 18], buffer[1 << 18];
+  static unsigned threads[] = { 1, 2, 8 };
+  char path[] = "/tmp/testaigtoaig-XXXXXX", cmd[64];
+  aiger *aiger = my_aiger_init ();
+  aiger_lit lhs;
+  unsigned i, j;
+  FILE *file;
+  int pipe;
+
+  for (i = 1; i <= 100; i++)
+    aiger_add_input (aiger, 2 * i, 0);
+  aiger_add_latch (aiger, 202, 2, "l");
+  for (i = 0; i < 20000; i++)
+    {
+      lhs = 2 * (102 + i);
+      aiger_add_and (aiger, lhs, lhs - 2 - (i % 7), 2 + 2 * (i % 100));
+    }
+  aiger_add_output (aiger, lhs, "o");
+
+  file = fdopen (mkstemp (path), "w");
+  assert (file);
+  assert (aiger_write_to_file (aiger, aiger_binary_mode, file));
+  assert (!fclose (file));
+  aiger_reset (aiger);
+
+  aiger = my_aiger_init ();
+  assert (!aiger_open_and_read_from_file (aiger, path));
+  assert (aiger_write_to_string (aiger, aiger_binary_mode,
+				 expected, sizeof expected));
+  aiger_reset (aiger);
+
+  sprintf (cmd, "cat %s", path);
+  for (pipe = 0; pipe < 2; pipe++)
+    for (j = 0; j < sizeof threads / sizeof *threads; j++)
+      {
+	file = pipe ? popen (cmd, "r") : fopen (path, "r");
+	assert (file);
+	aiger = my_aiger_init ();
+	assert (!aiger_read_parallel (aiger, file, threads[j]));
+	assert (pipe ? !pclose (file) : !fclose (file));
+	assert (aiger->num_ands == 20000);
+	assert (aiger_write_to_string (aiger, aiger_binary_mode,
+				       buffer, sizeof buffer));
+	assert (!memcmp (buffer, expected, sizeof buffer));
+	aiger_reset (aiger);
+      }
+
+  unlink (path);
+  assert (!mgr.bytes);
+}
+
+static void
+binary_size_and_new_buffer (void)
+{
+  aiger *aiger = my_aiger_init ();
+  char buffer[200], *res;
+  size_t size;
+
+  assert (!aiger_read_from_string (aiger, counter1));
+  assert (aiger_binary_size (aiger, aiger_ascii_mode) == strlen (counter1));
+  res = aiger_write_to_new_buffer (aiger, aiger_ascii_mode, &size);
+  assert (res && size == strlen (counter1) && !strcmp (res, counter1));
+  test_free (&mgr, res, size + 1);
+
+  size = aiger_binary_size (aiger, aiger_binary_mode);
+  assert (aiger_write_to_string (aiger, aiger_binary_mode, buffer, size + 1));
+  assert (!aiger_write_to_string (aiger, aiger_binary_mode, buffer, size));
+  res = aiger_write_to_new_buffer (aiger, aiger_binary_mode, &size);
+  assert (res && !memcmp (res, buffer, size + 1));
+  test_free (&mgr, res, size + 1);
+
+  assert (aiger_binary_size (aiger, aiger_binary_mode | aiger_stripped_mode)
+	  < size);
+  aiger_reset (aiger);
+  assert (!mgr.bytes);
+}
+
+static void
+binary_size_with_symbols_and_comments (void)
+{
+  static char buffer[1 << 16];
+  static aiger_mode modes[] = {
+    aiger_ascii_mode, aiger_binary_mode,
+    aiger_ascii_mode | aiger_stripped_mode,
+    aiger_binary_mode | aiger_stripped_mode
+  };
+  aiger *aiger = my_aiger_init ();
+  aiger_lit lhs, lits[2];
+  char name[32];
+  unsigned i;
+  size_t size;
+
+  for (i = 1; i <= 200; i++)
+    {
+      sprintf (name, "input%u", i);
+      aiger_add_input (aiger, 2 * i, (i % 3) ? name : 0);
+    }
+  aiger_add_latch (aiger, 402, 3, "latch");
+  aiger_add_reset (aiger, 402, 1);
+  aiger_add_latch (aiger, 404, 402, 0);
+  aiger_add_reset (aiger, 404, 404);
+  for (i = 0; i < 3000; i++)
+    {
+      lhs = 2 * (203 + i);
+      aiger_add_and (aiger, lhs, lhs - 1 - 2 * (i % 300), 2 + 2 * (i % 200));
+    }
+  aiger_add_output (aiger, lhs, "output");
+  aiger_add_output (aiger, lhs - 3, 0);
+  aiger_add_bad (aiger, lhs - 5, "bad");
+  aiger_add_constraint (aiger, 403, 0);
+  lits[0] = lhs - 7;
+  lits[1] = 1;
+  aiger_add_justice (aiger, 2, lits, "justice");
+  aiger_add_fairness (aiger, 405, "fairness");
+  aiger_add_comment (aiger, "first comment");
+  aiger_add_comment (aiger, "");
+  aiger_add_comment (aiger, "third comment");
+
+  for (i = 0; i < sizeof modes / sizeof *modes; i++)
+    {
+      size = aiger_binary_size (aiger, modes[i]);
+      assert (size < sizeof buffer);
+      assert (aiger_write_to_string (aiger, modes[i], buffer, size + 1));
+      assert (!aiger_write_to_string (aiger, modes[i], buffer, size));
+    }
+
+  aiger_reset (aiger);
+  assert (!mgr.bytes);
+}
+
+static void
+fanouts_and_levels (void)
+{
+  aiger *aiger = my_aiger_init ();
+  const aiger_fanouts *fanouts;
+
+  assert (!aiger_read_from_string (aiger, counter1));
+  fanouts = aiger_get_fanouts (aiger);
+  assert (fanouts->size == 9);
+  assert (fanouts->offsets[2] == 0 && fanouts->offsets[3] == 2);
+  assert (fanouts->targets[0] == 14 && fanouts->targets[1] == 17);
+  assert (fanouts->offsets[4] - fanouts->offsets[3] == 2);
+  assert (fanouts->offsets[5] == fanouts->offsets[4]);
+  assert (fanouts->targets[fanouts->offsets[5]] == 9);
+  assert (fanouts->offsets[9] == 8);
+  assert (!fanouts->levels[5] && fanouts->levels[4] == 3);
+  assert (fanouts->reverse_levels[2] == 3 && !fanouts->reverse_levels[4]);
+  assert (aiger_get_fanouts (aiger) == fanouts);
+  aiger_add_and (aiger, 18, 8, 2);
+  fanouts = aiger_get_fanouts (aiger);
+  assert (fanouts->size == 10 && fanouts->levels[9] == 4);
+  aiger_reset (aiger);
+  assert (!mgr.bytes);
+}
+
+typedef struct visited visited;
+
+struct visited
+{
+  unsigned inputs, latches, outputs, ands, symbols, comments;
+  aiger_lit header, sum;
+};
+
+static void
+visit_header (visited * v, const aiger_header * header)
+{
+  v->header = header->maxvar;
+}
+
+static void
+visit_input (visited * v, aiger_lit lit)
+{
+  v->inputs++;
+  v->sum += lit;
+}
+
+static void
+visit_latch (visited * v, aiger_lit lit, aiger_lit next, aiger_lit reset)
+{
+  v->latches++;
+  v->sum += lit + next + reset;
+}
+
+static void
+visit_output (visited * v, aiger_lit lit)
+{
+  v->outputs++;
+  v->sum += lit;
+}
+
+static void
+visit_and (visited * v, aiger_lit lhs, aiger_lit rhs0, aiger_lit rhs1)
+{
+  v->ands++;
+  v->sum += lhs + rhs0 + rhs1;
+}
+
+static void
+visit_symbol (visited * v, char type, unsigned pos, const char *name)
+{
+  v->symbols++;
+  v->sum += type + pos + strlen (name);
+}
+
+static void
+visit_comment (visited * v, const char *comment)
+{
+  v->comments++;
+  v->sum += strlen (comment);
+}
+
+static aiger_lit
+visit_counter1 (const char *str)
+{
+  aiger *aiger = my_aiger_init ();
+  aiger_visitor visitor;
+  visited v;
+
+  memset (&visitor, 0, sizeof visitor);
+  memset (&v, 0, sizeof v);
+  visitor.state = &v;
+  visitor.header = (void (*) (void *, const aiger_header *)) visit_header;
+  visitor.input = (void (*) (void *, aiger_lit)) visit_input;
+  visitor.latch =
+    (void (*) (void *, aiger_lit, aiger_lit, aiger_lit)) visit_latch;
+  visitor.output = (void (*) (void *, aiger_lit)) visit_output;
+  visitor.and_gate =
+    (void (*) (void *, aiger_lit, aiger_lit, aiger_lit)) visit_and;
+  visitor.symbol =
+    (void (*) (void *, char, unsigned, const char *)) visit_symbol;
+  visitor.comment = (void (*) (void *, const char *)) visit_comment;
+
+  aiger_set_visitor (aiger, &visitor);
+  assert (!aiger_read_from_string (aiger, str));
+  assert (v.inputs == 2 && v.latches == 1 && v.outputs == 1);
+  assert (v.ands == 4 && v.symbols == 4 && v.comments == 1);
+  assert (v.header == 8 || v.header == 7);
+  assert (!aiger->num_inputs && !aiger->num_ands && !aiger->comments[0]);
+  assert (aiger_read_from_string (aiger, "aag 1 0 0 1 0\n4\n"));
+  aiger_reset (aiger);
+  assert (!mgr.bytes);
+
+  return v.sum;
+}
+
+static void
+visitor_streaming (void)
+{
+  char buffer[200];
+  aiger *aiger;
+
+  visit_counter1 (counter1);
+
+  aiger = my_aiger_init ();
+  assert (!aiger_read_from_string (aiger, counter1r));
+  assert (aiger_write_to_string (aiger, aiger_binary_mode, buffer, 200));
+  aiger_reset (aiger);
+  assert (!mgr.bytes);
+
+  assert (visit_counter1 (counter1r) == visit_counter1 (buffer));
+}
+
+static void
+stream_writer (void)
+{
+  static aiger_lit justice[] = { 3, 6 };
+  char expected[200];
+  aiger_stream_writer *stream;
+  aiger_header header;
+  test_blocks blocks;
+  aiger *aiger;
+
+  aiger = my_aiger_init ();
+  assert (!aiger_read_from_string (aiger, counter1r));
+  aiger_add_bad (aiger, 12, 0);
+  aiger_add_justice (aiger, 2, justice, 0);
+  aiger_add_fairness (aiger, 7, 0);
+  assert (aiger_write_to_string (aiger, aiger_binary_mode, expected, 200));
+  aiger_reset (aiger);
+
+  memset (&header, 0, sizeof header);
+  header.maxvar = 7;
+  header.inputs = 2;
+  header.latches = 1;
+  header.outputs = 1;
+  header.ands = 4;
+  header.bad = 1;
+  header.justice = 1;
+  header.fairness = 1;
+
+  aiger = my_aiger_init ();
+  memset (&blocks, 0, sizeof blocks);
+  stream = aiger_new_stream_writer (aiger, &header, &blocks,
+				    (aiger_put_block) test_put_block);
+  assert (aiger_stream_latch (stream, 14, 0));
+  assert (aiger_stream_output (stream, 14));
+  assert (aiger_stream_bad (stream, 12));
+  assert (aiger_stream_justice (stream, 2, justice));
+  assert (aiger_stream_fairness (stream, 7));
+  assert (aiger_stream_and (stream, 6, 4) == 8);
+  assert (aiger_stream_and (stream, 5, 7) == 10);
+  assert (aiger_stream_and (stream, 11, 9) == 12);
+  assert (aiger_stream_and (stream, 12, 3) == 14);
+  assert (aiger_stream_symbol (stream, 'i', 0, "reset"));
+  assert (aiger_stream_symbol (stream, 'i', 1, "enable"));
+  assert (aiger_stream_symbol (stream, 'l', 0, "latch"));
+  assert (aiger_stream_symbol (stream, 'o', 0, "AIGER_NEVER"));
+  assert (aiger_stream_comment (stream,
+				"1-bit counter with reset and enable"));
+  assert (aiger_delete_stream_writer (stream));
+  aiger_reset (aiger);
+  assert (!mgr.bytes);
+
+  assert (blocks.len == strlen (expected));
+  assert (!memcmp (blocks.buffer, expected, blocks.len));
+
+  /* Too many and too few entries do not match the header.
+   */
+  aiger = my_aiger_init ();
+  memset (&blocks, 0, sizeof blocks);
+  stream = aiger_new_stream_writer (aiger, &header, &blocks,
+				    (aiger_put_block) test_put_block);
+  assert (aiger_stream_latch (stream, 14, 0));
+  assert (!aiger_stream_latch (stream, 14, 0));
+  assert (!aiger_stream_output (stream, 14));
+  assert (!aiger_delete_stream_writer (stream));
+
+  memset (&blocks, 0, sizeof blocks);
+  stream = aiger_new_stream_writer (aiger, &header, &blocks,
+				    (aiger_put_block) test_put_block);
+  assert (aiger_stream_latch (stream, 14, 0));
+  assert (aiger_stream_output (stream, 14));
+  assert (aiger_stream_bad (stream, 12));
+  assert (aiger_stream_justice (stream, 2, justice));
+  assert (aiger_stream_fairness (stream, 7));
+  assert (aiger_stream_and (stream, 6, 4) == 8);
+  assert (!aiger_delete_stream_writer (stream));
+  aiger_reset (aiger);
+  assert (!mgr.bytes);
+}
+
+#ifdef AIGER_WIDE
+
+static void
+wide_literals (void)
+{
+  static const char *ascii =
+    "aag 4294967297 1 0 1 1\n"
+    "8589934592\n"
+    "8589934594\n"
+    "8589934594 8589934592 3\n"
+    "i0 big\n";
+  aiger_lit big = (aiger_lit) 1 << 33;
+  aiger_visitor visitor;
+  aiger *aiger;
+  visited v;
+
+  /* Models with that many variables do not fit into memory, but visitors
+   * do not store them.
+   */
+  memset (&visitor, 0, sizeof visitor);
+  memset (&v, 0, sizeof v);
+  visitor.state = &v;
+  visitor.header = (void (*) (void *, const aiger_header *)) visit_header;
+  visitor.input = (void (*) (void *, aiger_lit)) visit_input;
+  visitor.output = (void (*) (void *, aiger_lit)) visit_output;
+  visitor.and_gate =
+    (void (*) (void *, aiger_lit, aiger_lit, aiger_lit)) visit_and;
+
+  aiger = my_aiger_init ();
+  aiger_set_visitor (aiger, &visitor);
+  assert (!aiger_read_from_string (aiger, ascii));
+  assert (v.header == big / 2 + 1);
+  assert (v.sum == big + (big + 2) + (big + 2) + big + 3);
+  assert (aiger_read_from_string (aiger, "aag 1 4294967296 0 0 0\n"));
+  aiger_reset (aiger);
+  assert (!mgr.bytes);
+}
+
+#endif
+
 int
 main (void)
 {
@@ -301,10 +1080,30 @@ main (void)
   rhs_undefined ();
   cyclic0 ();
   cyclic1 ();
+  check_cached ();
   write_empty ();
   write_false ();
   write_true ();
   write_and ();
   reencode_counter1 ();
+  write_and_read_blocks ();
+  coi_and_coi_of_lits ();
+  reserve_and_realloc ();
+  compact_ands ();
+  header_only_and_skip_ands ();
+  lazy_symbols ();
+  arena_names_and_strip ();
+  find_symbols ();
+  reencode_in_order ();
+  write_threads ();
+  read_parallel ();
+  binary_size_and_new_buffer ();
+  binary_size_with_symbols_and_comments ();
+  fanouts_and_levels ();
+  visitor_streaming ();
+  stream_writer ();
+#ifdef AIGER_WIDE
+  wide_literals ();
+#endif
   return 0;
 }